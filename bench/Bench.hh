@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// Minimal host-side microbenchmark harness. Each benchmark registers
+// itself with BENCHMARK() and loops on state.Running(); results are
+// printed as one JSON object per line.
+
+#ifndef TEXASTORQUE_BENCH
+#define TEXASTORQUE_BENCH
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace texastorque {
+    namespace bench {
+        // Heap allocations so far on any thread, counted by the global
+        // operator new in Main.cc.
+        uint64_t AllocationCount();
+
+        // Also called with the size of every heap allocation when set,
+        // e.g. for per-stage accounting. Set it before any threads start.
+        extern void (*allocationHook)(std::size_t);
+
+        class State {
+        public:
+            explicit State(double minSeconds) : minSeconds(minSeconds) {}
+
+            // True until enough iterations have run; the timer starts on
+            // the first call.
+            bool Running();
+
+            // Bytes touched per iteration, for MB/s.
+            void SetBytesPerIteration(uint64_t bytes) {
+                bytesPerIteration = bytes;
+            }
+
+            // Marks the benchmark as not runnable here (e.g. a missing
+            // model); Running() then returns false straight away.
+            void Skip(const std::string& reason) {
+                skipped = reason;
+            }
+
+            const std::string& Skipped() const {
+                return skipped;
+            }
+
+            // Fails the run if the timed loop allocates at all.
+            void ExpectNoAllocations() {
+                allocationFree = true;
+            }
+
+            bool AllocationFree() const {
+                return allocationFree;
+            }
+
+            // Extra named results (e.g. accuracy), printed with the timing.
+            void SetCounter(const std::string& name, double value) {
+                counters.emplace_back(name, value);
+            }
+
+            const std::vector<std::pair<std::string, double>>& Counters() const {
+                return counters;
+            }
+
+            uint64_t Iterations() const {
+                return iterations;
+            }
+
+            double Seconds() const {
+                return seconds;
+            }
+
+            uint64_t BytesPerIteration() const {
+                return bytesPerIteration;
+            }
+
+            double AllocationsPerIteration() const {
+                return iterations == 0 ? 0
+                        : static_cast<double>(allocations) / iterations;
+            }
+
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            double minSeconds;
+            uint64_t iterations = 0;
+            uint64_t nextCheck = 1;
+            uint64_t bytesPerIteration = 0;
+            uint64_t allocations = 0;
+            bool allocationFree = false;
+            double seconds = 0;
+            Clock::time_point start;
+            std::string skipped;
+            std::vector<std::pair<std::string, double>> counters;
+        };
+
+        struct Benchmark {
+            std::string name;
+            std::function<void(State&)> fn;
+            double budgetNs;  // 0 for none
+        };
+
+        std::vector<Benchmark>& Registry();
+
+        struct Registrar {
+            Registrar(const char* name, std::function<void(State&)> fn,
+                      double budgetNs = 0) {
+                Registry().push_back({name, fn, budgetNs});
+            }
+        };
+
+        // Keeps the optimiser from discarding a result.
+        template <typename T>
+        inline void DoNotOptimize(const T& value) {
+            asm volatile("" : : "r,m"(value) : "memory");
+        }
+    }
+}
+
+#define BENCH_CONCAT2(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT2(a, b)
+
+// BENCHMARK("name", fn) or BENCHMARK("name", fn, budgetNs)
+#define BENCHMARK(...)                                                  \
+    static ::texastorque::bench::Registrar BENCH_CONCAT(benchRegistrar, \
+                                                        __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "Bench.hh"
+
+namespace {
+    std::atomic<uint64_t> allocationCount{0};
+}
+
+void (*texastorque::bench::allocationHook)(std::size_t) = nullptr;
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (auto hook = texastorque::bench::allocationHook) hook(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace texastorque {
+    namespace bench {
+        uint64_t AllocationCount() {
+            return allocationCount.load(std::memory_order_relaxed);
+        }
+
+        std::vector<Benchmark>& Registry() {
+            static std::vector<Benchmark> registry;
+            return registry;
+        }
+
+        bool State::Running() {
+            if (!skipped.empty()) return false;
+            if (iterations == 0) {
+                allocations = AllocationCount();
+                start = Clock::now();
+            }
+            if (iterations++ < nextCheck) return true;
+            seconds = std::chrono::duration<double>(Clock::now() - start)
+                              .count();
+            if (seconds >= minSeconds) {
+                --iterations;
+                allocations = AllocationCount() - allocations;
+                return false;
+            }
+            nextCheck *= 2;
+            return true;
+        }
+    }
+}
+
+// usage: bench [--time seconds] [name filter]
+int main(int argc, char* argv[]) {
+    using namespace texastorque::bench;
+
+    double minSeconds = 0.5;
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            minSeconds = std::atof(argv[++i]);
+        else
+            filter = argv[i];
+    }
+
+    int failed = 0;
+    for (auto& b : Registry()) {
+        if (filter != nullptr && b.name.find(filter) == std::string::npos)
+            continue;
+        State state(minSeconds);
+        b.fn(state);
+        if (!state.Skipped().empty()) {
+            std::printf("{\"name\":\"%s\",\"skipped\":\"%s\"}\n",
+                        b.name.c_str(), state.Skipped().c_str());
+            continue;
+        }
+        double ns = state.Iterations() == 0
+                ? 0 : state.Seconds() * 1e9 / state.Iterations();
+        double mbps = state.Seconds() == 0
+                ? 0 : state.BytesPerIteration() * state.Iterations() /
+                              state.Seconds() / 1e6;
+        std::printf("{\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.1f,"
+                    "\"mb_per_s\":%.1f,\"allocs_per_op\":%.2f",
+                    b.name.c_str(),
+                    static_cast<unsigned long long>(state.Iterations()), ns,
+                    mbps, state.AllocationsPerIteration());
+        for (const auto& counter : state.Counters())
+            std::printf(",\"%s\":%g", counter.first.c_str(), counter.second);
+        if (state.AllocationFree()) {
+            bool ok = state.AllocationsPerIteration() == 0;
+            if (!ok) ++failed;
+            std::printf(",\"allocation_free\":%s", ok ? "true" : "false");
+        }
+        if (b.budgetNs > 0) {
+            bool ok = ns <= b.budgetNs;
+            if (!ok) ++failed;
+            std::printf(",\"budget_ns\":%.0f,\"within_budget\":%s", b.budgetNs,
+                        ok ? "true" : "false");
+        }
+        std::printf("}\n");
+    }
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
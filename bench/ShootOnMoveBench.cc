@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "Bench.hh"
+#include "ShootOnMove.hh"
+
+using namespace texastorque;
+
+namespace {
+    // Representative 2022 table: distance, rpm, hood, time of flight.
+    ShooterLut MakeLut() {
+        return ShooterLut({{1.5, 2000, 10, 0.70},
+                           {2.5, 2300, 18, 0.85},
+                           {3.5, 2600, 24, 1.00},
+                           {4.5, 2950, 29, 1.12},
+                           {5.5, 3400, 33, 1.25},
+                           {6.5, 3900, 36, 1.38}},
+                          0.01);
+    }
+
+    // The per-frame cost is one solve; the budget is 50 us.
+    void SolveMoving(bench::State& state) {
+        ShooterLut lut = MakeLut();
+        int i = 0;
+        while (state.Running()) {
+            double v = (i++ % 64) / 16.0 - 2.0;
+            MovingShot shot = SolveMovingShot(lut, 5.0, 3.2, 0.678, v,
+                                              1.0 - v / 2, 0.0);
+            bench::DoNotOptimize(shot);
+        }
+    }
+
+    void SolveMovingWorstCase(bench::State& state) {
+        ShooterLut lut = MakeLut();
+        while (state.Running()) {
+            MovingShot shot = SolveMovingShot(lut, 40.0, 6.0, 0.678, -4.0, 3.0,
+                                              0.0, 6, 0.0);
+            bench::DoNotOptimize(shot);
+        }
+    }
+
+    void LookupSetpoints(bench::State& state) {
+        ShooterLut lut = MakeLut();
+        double d = 1.0, rpm, hood;
+        while (state.Running()) {
+            lut.Lookup(d, rpm, hood);
+            bench::DoNotOptimize(rpm);
+            d = d > 7.0 ? 1.0 : d + 0.013;
+        }
+    }
+}
+
+BENCHMARK("shoot_on_move/solve", SolveMoving, 50000);
+BENCHMARK("shoot_on_move/solve_iteration_cap", SolveMovingWorstCase, 50000);
+BENCHMARK("shooter/lookup", LookupSetpoints);
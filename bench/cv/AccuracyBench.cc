@@ -0,0 +1,155 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// Accuracy and throughput together on generated frames. Each benchmark
+// first renders BENCH_SYNTHETIC random scenes (default 1000), runs the
+// detector on each and scores it against the ground truth, then times
+// the detector over a ring of pre-rendered frames. Accuracy is reported
+// as extra fields next to ns_per_op.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.hh"
+#include "CargoDetector.hh"
+#include "HubDetector.hh"
+#include "SyntheticFrame.hh"
+
+using namespace texastorque;
+
+namespace {
+    constexpr int kRing = 32;
+
+    int SceneCount() {
+        const char* n = std::getenv("BENCH_SYNTHETIC");
+        return n == nullptr ? 1000 : std::max(1, std::atoi(n));
+    }
+
+    double Quantile(std::vector<double> values, double q) {
+        if (values.empty()) return 0;
+        auto nth = values.begin() + static_cast<long>(q * (values.size() - 1));
+        std::nth_element(values.begin(), nth, values.end());
+        return *nth;
+    }
+
+    void RenderRing(SyntheticGenerator& generator, std::vector<cv::Mat>& ring) {
+        ring.resize(kRing);
+        for (auto& frame : ring) generator.Render(generator.RandomScene(), frame);
+    }
+
+    void HubAccuracy(bench::State& state, cv::Size size) {
+        SyntheticCamera camera;
+        camera.size = size;
+        HubConfig config;
+        config.horizontalFov = camera.horizontalFov;
+        config.verticalFov = camera.verticalFov;
+        config.cameraHeight = camera.height;
+        config.cameraPitch = camera.pitch;
+        HubDetector detector(config);
+        SyntheticGenerator generator(camera);
+        Metrics metrics;
+        cv::Mat frame;
+        Result result{};
+
+        int scenes = SceneCount(), visible = 0, found = 0;
+        std::vector<double> yawError, distanceError;
+        for (int i = 0; i < scenes; ++i) {
+            SyntheticTruth truth = generator.Render(generator.RandomScene(), frame);
+            detector.Detect(frame, metrics, result);
+            if (truth.tapes.size() < 2) continue;
+            ++visible;
+            if (!result.found) continue;
+            ++found;
+            yawError.push_back(std::abs(result.yaw - truth.yaw));
+            distanceError.push_back(std::abs(result.distance - truth.distance) /
+                                    truth.distance);
+        }
+        state.SetCounter("scenes", scenes);
+        state.SetCounter("found_rate", visible == 0 ? 0 : 1.0 * found / visible);
+        state.SetCounter("yaw_err_p50", Quantile(yawError, 0.5));
+        state.SetCounter("yaw_err_p95", Quantile(yawError, 0.95));
+        state.SetCounter("distance_rel_err_p50", Quantile(distanceError, 0.5));
+        state.SetCounter("distance_rel_err_p95", Quantile(distanceError, 0.95));
+
+        std::vector<cv::Mat> ring;
+        RenderRing(generator, ring);
+        state.SetBytesPerIteration(ring[0].total() * ring[0].elemSize());
+        int i = 0;
+        while (state.Running()) {
+            detector.Detect(ring[i], metrics, result);
+            bench::DoNotOptimize(result);
+            i = (i + 1) % kRing;
+        }
+    }
+
+    double Iou(const cv::Rect& a, const cv::Rect& b) {
+        double overlap = (a & b).area();
+        return overlap / (a.area() + b.area() - overlap);
+    }
+
+    // Needs CARGO_MODEL like the inference benchmarks. A detection counts
+    // if it overlaps an unmatched ball of the right colour by IoU 0.5,
+    // with the model's class 0 taken as red.
+    void CargoAccuracy(bench::State& state) {
+        CargoConfig config;
+        const char* model = std::getenv("CARGO_MODEL");
+        if (model == nullptr) {
+            state.Skip("CARGO_MODEL not set");
+            return;
+        }
+        config.model = model;
+        if (const char* c = std::getenv("CARGO_CONFIG")) config.config = c;
+        CargoDetector detector(config);
+        SyntheticGenerator generator;
+        cv::Mat frame;
+        std::vector<cv::Mat> frames(1);
+        std::vector<cv::Size> sizes(1);
+        std::vector<CargoDetections> detections;
+
+        int balls = 0, detected = 0, matched = 0, scenes = SceneCount();
+        for (int i = 0; i < scenes; ++i) {
+            SyntheticTruth truth = generator.Render(generator.RandomScene(), frame);
+            frames[0] = frame;
+            sizes[0] = frame.size();
+            detector.Detect(frames, sizes, detections);
+            balls += static_cast<int>(truth.cargo.size());
+            detected += detections[0].count;
+            std::vector<bool> used(truth.cargo.size());
+            for (int d = 0; d < detections[0].count; ++d) {
+                const Box& b = detections[0].cargo[d].box;
+                cv::Rect box(b.x, b.y, b.width, b.height);
+                bool red = detections[0].cargo[d].label == 0;
+                for (size_t t = 0; t < truth.cargo.size(); ++t) {
+                    if (used[t] || truth.cargo[t].red != red ||
+                        Iou(box, truth.cargo[t].box) < 0.5)
+                        continue;
+                    used[t] = true;
+                    ++matched;
+                    break;
+                }
+            }
+        }
+        state.SetCounter("scenes", scenes);
+        state.SetCounter("recall", balls == 0 ? 0 : 1.0 * matched / balls);
+        state.SetCounter("precision", detected == 0 ? 0 : 1.0 * matched / detected);
+
+        std::vector<cv::Mat> ring;
+        RenderRing(generator, ring);
+        int i = 0;
+        while (state.Running()) {
+            frames[0] = ring[i];
+            detector.Detect(frames, sizes, detections);
+            bench::DoNotOptimize(detections.data());
+            i = (i + 1) % kRing;
+        }
+    }
+}
+
+BENCHMARK("accuracy/hub/320x240", [](bench::State& s) { HubAccuracy(s, {320, 240}); });
+BENCHMARK("accuracy/hub/640x480", [](bench::State& s) { HubAccuracy(s, {640, 480}); });
+BENCHMARK("accuracy/cargo", CargoAccuracy);
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// Cargo detector inference latency. Needs a model: set CARGO_MODEL (and
+// CARGO_CONFIG, plus CARGO_WIDTH/CARGO_HEIGHT if not 300x300) to the same
+// files as the "cargo" section of frc.json. Run on both the dev machine
+// and the Pi; ns_per_op is per forward pass, so divide the batch
+// benchmarks by their batch size for per-frame cost.
+
+#include <cstdlib>
+
+#include "opencv2/imgproc.hpp"
+
+#include "Bench.hh"
+#include "CargoDetector.hh"
+
+using namespace texastorque;
+
+namespace {
+    bool ConfigFromEnv(CargoConfig& config) {
+        const char* model = std::getenv("CARGO_MODEL");
+        if (model == nullptr) return false;
+        config.model = model;
+        if (const char* c = std::getenv("CARGO_CONFIG")) config.config = c;
+        if (const char* w = std::getenv("CARGO_WIDTH"))
+            config.inputWidth = std::atoi(w);
+        if (const char* h = std::getenv("CARGO_HEIGHT"))
+            config.inputHeight = std::atoi(h);
+        return true;
+    }
+
+    // Noise rather than a blank frame, so nothing is trivially zero.
+    cv::Mat Frame(const cv::Size& size) {
+        cv::Mat frame(size, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+        return frame;
+    }
+
+    void Infer(bench::State& state, int batch) {
+        CargoConfig config;
+        if (!ConfigFromEnv(config)) {
+            state.Skip("CARGO_MODEL not set");
+            return;
+        }
+        CargoDetector detector(config);
+        cv::Size input(config.inputWidth, config.inputHeight);
+        std::vector<cv::Mat> frames(batch, Frame(input));
+        std::vector<cv::Size> sizes(batch, cv::Size(640, 480));
+        std::vector<CargoDetections> detections;
+
+        detector.Detect(frames, sizes, detections);  // warm up
+        state.SetBytesPerIteration(batch * input.area() * 3);
+        while (state.Running()) {
+            detector.Detect(frames, sizes, detections);
+            bench::DoNotOptimize(detections.data());
+        }
+    }
+
+    // What a vision thread pays when the detector asks for a frame.
+    void Downscale(bench::State& state) {
+        cv::Mat frame = Frame(cv::Size(640, 480)), small;
+        state.SetBytesPerIteration(frame.total() * frame.elemSize());
+        while (state.Running()) {
+            cv::resize(frame, small, cv::Size(300, 300), 0, 0, cv::INTER_AREA);
+            bench::DoNotOptimize(small.data);
+        }
+    }
+}
+
+BENCHMARK("cargo/downscale", Downscale, 1e6);
+BENCHMARK("cargo/infer_batch1", [](bench::State& s) { Infer(s, 1); });
+BENCHMARK("cargo/infer_batch2", [](bench::State& s) { Infer(s, 2); });
+BENCHMARK("cargo/infer_batch4", [](bench::State& s) { Infer(s, 4); });
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// BGR to hub mask: cvtColor + inRange against the bit-packed colour LUT
+// at 32^3 and 64^3 cells, on a generated 640x480 hub frame. The LUT
+// benchmarks also report agreement, the fraction of pixels classified
+// the same as the direct path. Run on both the dev machine and the Pi.
+
+#include "opencv2/imgproc.hpp"
+
+#include "Bench.hh"
+#include "ColorLut.hh"
+#include "HubDetector.hh"
+#include "SyntheticFrame.hh"
+
+using namespace texastorque;
+
+namespace {
+    cv::Mat Frame() {
+        SyntheticScene scene;
+        scene.distance = 3;
+        scene.noise = 6;
+        scene.distractors = 2;
+        cv::Mat frame;
+        SyntheticGenerator(SyntheticCamera{}).Render(scene, frame);
+        return frame;
+    }
+
+    void Direct(bench::State& state, ColorSpace space) {
+        HubConfig config;
+        cv::Mat frame = Frame(), converted, mask;
+        auto code = space == ColorSpace::kHsv ? cv::COLOR_BGR2HSV
+                                              : cv::COLOR_BGR2YCrCb;
+        state.SetBytesPerIteration(frame.total() * frame.elemSize());
+        while (state.Running()) {
+            cv::cvtColor(frame, converted, code);
+            cv::inRange(converted, config.lower, config.upper, mask);
+            bench::DoNotOptimize(mask.data);
+        }
+    }
+
+    void Lut(bench::State& state, ColorSpace space, int bits) {
+        HubConfig config;
+        ColorLut lut(config.lower, config.upper, space, bits);
+        cv::Mat frame = Frame(), converted, exact, mask;
+        cv::cvtColor(frame, converted, space == ColorSpace::kHsv
+                                               ? cv::COLOR_BGR2HSV
+                                               : cv::COLOR_BGR2YCrCb);
+        cv::inRange(converted, config.lower, config.upper, exact);
+        lut.Classify(frame, mask);
+        state.SetCounter("agreement",
+                         1.0 - double(cv::countNonZero(exact != mask)) /
+                                       frame.total());
+
+        state.SetBytesPerIteration(frame.total() * frame.elemSize());
+        while (state.Running()) {
+            lut.Classify(frame, mask);
+            bench::DoNotOptimize(mask.data);
+        }
+    }
+
+    // What an NT threshold change costs the callback thread.
+    void Build(bench::State& state, int bits) {
+        HubConfig config;
+        while (state.Running()) {
+            ColorLut lut(config.lower, config.upper, ColorSpace::kHsv, bits);
+            bench::DoNotOptimize(lut);
+        }
+    }
+}
+
+BENCHMARK("color/inrange_hsv", [](bench::State& s) {
+    Direct(s, ColorSpace::kHsv);
+});
+BENCHMARK("color/inrange_ycrcb", [](bench::State& s) {
+    Direct(s, ColorSpace::kYCrCb);
+});
+BENCHMARK("color/lut32_hsv", [](bench::State& s) {
+    Lut(s, ColorSpace::kHsv, 5);
+});
+BENCHMARK("color/lut64_hsv", [](bench::State& s) {
+    Lut(s, ColorSpace::kHsv, 6);
+});
+BENCHMARK("color/build_lut32", [](bench::State& s) { Build(s, 5); });
+BENCHMARK("color/build_lut64", [](bench::State& s) { Build(s, 6); });
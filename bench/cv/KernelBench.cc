@@ -0,0 +1,336 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// One benchmark per pipeline kernel and input, named
+// kernel/<stage>/<input>. Inputs are generated frames at several
+// resolutions plus, if BENCH_FRAMES names a directory, the recorded
+// frames in it (png/jpg, cycled in order). Mat buffers are counted in
+// allocs_per_op through the UMatData header OpenCV news for each one.
+// Mask stages also run as <stage>_packed and <stage>_lut_packed, with
+// 1-bit masks from inRange or straight from the colour LUT.
+// kernel/frame/<input> runs a frame's flip, hub detection and JSON
+// publish and fails if a warmed-up frame allocates, naming the stages
+// that did. Tracking, filtering, pose, shooter, NT, stream and shared
+// memory stages need a live Pipeline and are not covered; the
+// allocations/* NT counters watch those on the robot.
+
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include "Allocations.hh"
+#include "Bench.hh"
+#include "HubDetector.hh"
+#include "PerfCounters.hh"
+#include "ResultJson.hh"
+#include "SyntheticFrame.hh"
+
+using namespace texastorque;
+
+namespace {
+    using Frames = std::vector<cv::Mat>;
+
+    // The hub 3 m out, slightly off centre, with cargo, lights and noise.
+    cv::Mat SyntheticFrame(cv::Size size) {
+        SyntheticCamera camera;
+        camera.size = size;
+        SyntheticScene scene;
+        scene.distance = 3;
+        scene.yaw = 5;
+        scene.cargo = {{2.0, -10, true}, {2.5, 15, false}};
+        scene.distractors = 2;
+        scene.noise = 6;
+        scene.blur = 0.8;
+        cv::Mat frame;
+        SyntheticGenerator(camera).Render(scene, frame);
+        return frame;
+    }
+
+    Frames Recorded() {
+        Frames frames;
+        const char* dir = std::getenv("BENCH_FRAMES");
+        if (dir == nullptr) return frames;
+        std::vector<cv::String> paths, jpgs;
+        cv::glob(std::string(dir) + "/*.png", paths);
+        cv::glob(std::string(dir) + "/*.jpg", jpgs);
+        paths.insert(paths.end(), jpgs.begin(), jpgs.end());
+        for (const auto& path : paths) {
+            cv::Mat frame = cv::imread(path, cv::IMREAD_COLOR);
+            if (!frame.empty()) frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    struct Input {
+        std::string name;
+        std::function<Frames()> load;
+    };
+
+    std::vector<Input> Inputs() {
+        std::vector<Input> inputs;
+        for (cv::Size s : {cv::Size(320, 240), cv::Size(640, 480),
+                           cv::Size(1280, 720)}) {
+            inputs.push_back({std::to_string(s.width) + "x" +
+                                      std::to_string(s.height),
+                              [s] { return Frames{SyntheticFrame(s)}; }});
+        }
+        inputs.push_back({"recorded", Recorded});
+        return inputs;
+    }
+
+    // Hardware counter ratios over the timed loop, when perf_event_open
+    // is allowed; otherwise the benchmark reports timing only.
+    void ReportCounters(bench::State& state, const PerfCounters& perf,
+                        const PerfSample& before, const PerfSample& after,
+                        double pixels) {
+        auto delta = [&](PerfEvent e) {
+            return static_cast<double>(after[static_cast<int>(e)] -
+                                       before[static_cast<int>(e)]);
+        };
+        if (delta(PerfEvent::kCycles) > 0)
+            state.SetCounter("ipc", delta(PerfEvent::kInstructions) /
+                                            delta(PerfEvent::kCycles));
+        if (perf.Has(PerfEvent::kL1dMisses))
+            state.SetCounter("l1d_misses_per_pixel",
+                             delta(PerfEvent::kL1dMisses) / pixels);
+        if (perf.Has(PerfEvent::kLlcMisses))
+            state.SetCounter("llc_misses_per_pixel",
+                             delta(PerfEvent::kLlcMisses) / pixels);
+        if (perf.Has(PerfEvent::kBranchMisses))
+            state.SetCounter("branch_misses_per_pixel",
+                             delta(PerfEvent::kBranchMisses) / pixels);
+    }
+
+    // Loads the input, runs prepare once per frame to get the detector
+    // to the state the kernel starts from, then times kernel over the
+    // frames in turn.
+    using Kernel = std::function<void(HubDetector&, const cv::Mat&, Result&)>;
+
+    void RunKernel(bench::State& state, const Input& input,
+                   const HubConfig& config, Kernel prepare, Kernel kernel) {
+        Frames frames = input.load();
+        if (frames.empty()) {
+            state.Skip("BENCH_FRAMES not set or empty");
+            return;
+        }
+        std::vector<HubDetector> detectors(frames.size());
+        for (auto& detector : detectors) detector.SetConfig(config);
+        std::vector<Result> results(frames.size());
+        uint64_t bytes = 0, pixels = 0;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (prepare) prepare(detectors[i], frames[i], results[i]);
+            kernel(detectors[i], frames[i], results[i]);  // warm up buffers
+            bytes += frames[i].total() * frames[i].elemSize();
+            pixels += frames[i].total();
+        }
+        state.SetBytesPerIteration(bytes / frames.size());
+
+        PerfCounters perf;
+        PerfSample before, after;
+        perf.Open();
+        perf.Read(before);
+        size_t i = 0;
+        while (state.Running()) {
+            kernel(detectors[i], frames[i], results[i]);
+            bench::DoNotOptimize(results[i]);
+            if (++i == frames.size()) i = 0;
+        }
+        if (!perf.Read(after) || state.Iterations() == 0) return;
+        ReportCounters(state, perf, before, after,
+                       double(pixels) / frames.size() * state.Iterations());
+    }
+
+    void Convert(HubDetector& d, const cv::Mat& frame, Result&) {
+        d.Convert(frame);
+    }
+
+    void ConvertThreshold(HubDetector& d, const cv::Mat& frame, Result&) {
+        d.Convert(frame);
+        d.Threshold();
+    }
+
+    void UpToContours(HubDetector& d, const cv::Mat& frame, Result&) {
+        d.Convert(frame);
+        d.Threshold();
+        d.Morphology();
+    }
+
+    void UpToFit(HubDetector& d, const cv::Mat& frame, Result& result) {
+        UpToContours(d, frame, result);
+        d.FindTapes(result);
+    }
+
+    void UpToPublish(HubDetector& d, const cv::Mat& frame, Result& result) {
+        UpToFit(d, frame, result);
+        d.FitHub(frame.size(), result);
+        result.filtered = result.found;
+        result.filteredYaw = result.yaw;
+        result.filteredPitch = result.pitch;
+        result.filteredDistance = result.distance;
+        result.filteredConfidence = result.confidence;
+    }
+
+    // Output sink for the JSON kernel: a reused buffer, like the
+    // SmallString the feed writes into.
+    class Sink {
+    public:
+        Sink& operator<<(const char* s) {
+            while (*s != '\0' && length < sizeof(buffer)) buffer[length++] = *s++;
+            return *this;
+        }
+        Sink& operator<<(char c) {
+            if (length < sizeof(buffer)) buffer[length++] = c;
+            return *this;
+        }
+        template <typename T>
+        Sink& operator<<(T value) {
+            char digits[24];
+            auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            *end = '\0';
+            return *this << static_cast<const char*>(digits);
+        }
+        void Clear() {
+            length = 0;
+        }
+
+    private:
+        char buffer[1024];
+        size_t length = 0;
+    };
+
+    // Flip, detect and publish as Process does, with the detector's stage
+    // timers attributing allocations.
+    void RunFrame(bench::State& state, const Input& input) {
+        CountingMatAllocator::Install();
+        Frames frames = input.load();
+        if (frames.empty()) {
+            state.Skip("BENCH_FRAMES not set or empty");
+            return;
+        }
+        std::vector<HubDetector> detectors(frames.size());
+        std::vector<Result> results(frames.size());
+        std::vector<cv::Mat> flipped(frames.size());
+        Metrics metrics;
+        Sink sink;
+        auto frame = [&](size_t i) {
+            {
+                StageTimer t(metrics, Stage::kFlip);
+                cv::flip(frames[i], flipped[i], 0);
+            }
+            detectors[i].Detect(flipped[i], metrics, results[i]);
+            StageTimer t(metrics, Stage::kPublish);
+            sink.Clear();
+            WriteResultJson(sink, "Front", results[i]);
+        };
+        for (size_t i = 0; i < frames.size(); ++i) frame(i);  // warm up
+
+        std::array<AllocationCounts, kStageCount> warm;
+        for (int s = 0; s < kStageCount; ++s)
+            warm[s] = metrics.allocations[s].Load();
+        state.ExpectNoAllocations();
+        size_t i = 0;
+        while (state.Running()) {
+            frame(i);
+            bench::DoNotOptimize(results[i]);
+            if (++i == frames.size()) i = 0;
+        }
+        if (state.Iterations() == 0) return;
+        for (int s = 0; s < kStageCount; ++s) {
+            AllocationCounts now = metrics.allocations[s].Load();
+            uint64_t count = now.heap - warm[s].heap + now.mat - warm[s].mat;
+            if (count == 0) continue;
+            state.SetCounter(std::string("allocs_per_op_") +
+                                     StageName(static_cast<Stage>(s)),
+                             double(count) / state.Iterations());
+        }
+    }
+
+    struct Registration {
+        Registration() {
+            bench::allocationHook = CountHeapAllocation;
+            struct Stage {
+                const char* name;
+                Kernel prepare, kernel;
+                bool masked;  // also run with packed masks
+            };
+            std::vector<Stage> stages = {
+                    {"flip", nullptr,
+                     [](HubDetector&, const cv::Mat& frame, Result&) {
+                         static thread_local cv::Mat flipped;
+                         cv::flip(frame, flipped, 0);
+                     }, false},
+                    {"convert", nullptr, Convert, false},
+                    {"threshold", Convert,
+                     [](HubDetector& d, const cv::Mat&, Result&) {
+                         d.Threshold();
+                     }, true},
+                    {"morphology", ConvertThreshold,
+                     [](HubDetector& d, const cv::Mat&, Result&) {
+                         d.Morphology();
+                     }, true},
+                    {"contours", UpToContours,
+                     [](HubDetector& d, const cv::Mat&, Result& result) {
+                         d.FindTapes(result);
+                     }, true},
+                    {"hub_fit", UpToFit,
+                     [](HubDetector& d, const cv::Mat& frame, Result& result) {
+                         d.FitHub(frame.size(), result);
+                     }, false},
+                    {"publish_json", UpToPublish,
+                     [](HubDetector&, const cv::Mat&, Result& result) {
+                         static thread_local Sink sink;
+                         sink.Clear();
+                         WriteResultJson(sink, "Front", result);
+                     }, false},
+                    {"detect", nullptr,
+                     [](HubDetector& d, const cv::Mat& frame, Result& result) {
+                         static thread_local Metrics metrics;
+                         d.Detect(frame, metrics, result);
+                     }, true},
+            };
+
+            // Mask stages again with the mask packed after inRange, and
+            // packed straight from the colour LUT.
+            struct Variant {
+                const char* suffix;
+                HubConfig config;
+            };
+            HubConfig packed, lutPacked;
+            packed.packedMask = lutPacked.packedMask = true;
+            lutPacked.lutBits = 5;
+            std::vector<Variant> variants = {{"", HubConfig{}},
+                                             {"_packed", packed},
+                                             {"_lut_packed", lutPacked}};
+            for (const Input& input : Inputs()) {
+                for (const Variant& variant : variants) {
+                    for (const Stage& stage : stages) {
+                        if (*variant.suffix != '\0' && !stage.masked) continue;
+                        std::string name = std::string("kernel/") + stage.name +
+                                           variant.suffix + "/" + input.name;
+                        HubConfig config = variant.config;
+                        bench::Registry().push_back(
+                                {name,
+                                 [input, config, stage](bench::State& state) {
+                                     RunKernel(state, input, config,
+                                               stage.prepare, stage.kernel);
+                                 },
+                                 0});
+                    }
+                }
+                bench::Registry().push_back(
+                        {"kernel/frame/" + input.name,
+                         [input](bench::State& state) { RunFrame(state, input); },
+                         0});
+            }
+        }
+    } registration;
+}
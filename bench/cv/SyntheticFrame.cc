@@ -0,0 +1,162 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "SyntheticFrame.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "opencv2/imgproc.hpp"
+
+namespace texastorque {
+    static constexpr double kRadians = CV_PI / 180.0;
+
+    // 2022 upper hub: 16 strips of 5 x 2 in tape around the rim.
+    static constexpr int kStrips = 16;
+    static constexpr double kStripWidth = 0.127;
+    static constexpr double kStripHeight = 0.0508;
+    static constexpr double kHubRadius = 0.678;
+    static constexpr double kHubHeight = 2.64;
+    static constexpr double kCargoRadius = 0.12;
+
+    SyntheticGenerator::SyntheticGenerator(const SyntheticCamera& camera,
+                                           uint64_t seed)
+            : camera(camera), rng(seed) {
+        fx = camera.size.width / 2.0 /
+             std::tan(camera.horizontalFov / 2.0 * kRadians);
+        fy = camera.size.height / 2.0 /
+             std::tan(camera.verticalFov / 2.0 * kRadians);
+    }
+
+    bool SyntheticGenerator::Project(const cv::Point3d& p,
+                                     cv::Point2d& pixel) const {
+        double pitch = camera.pitch * kRadians;
+        double z = p.z - camera.height;
+        double forward = p.x * std::cos(pitch) + z * std::sin(pitch);
+        double down = p.x * std::sin(pitch) - z * std::cos(pitch);
+        double right = -p.y;
+        if (forward <= 0.01) return false;
+        pixel.x = camera.size.width / 2.0 + fx * right / forward;
+        pixel.y = camera.size.height / 2.0 + fy * down / forward;
+        return true;
+    }
+
+    cv::Point3d SyntheticGenerator::FloorPoint(double distance, double yaw,
+                                               double z) const {
+        return {distance * std::cos(yaw * kRadians),
+                -distance * std::sin(yaw * kRadians), z};
+    }
+
+    SyntheticTruth SyntheticGenerator::Render(const SyntheticScene& scene,
+                                              cv::Mat& frame) {
+        SyntheticTruth truth;
+
+        // Dim gym: darker ceiling, lighter floor.
+        frame.create(camera.size, CV_8UC3);
+        for (int y = 0; y < frame.rows; ++y)
+            frame.row(y).setTo(cv::Scalar::all(25 + 40 * y / frame.rows));
+
+        for (int i = 0; i < scene.distractors; ++i) {
+            cv::Point c(rng.uniform(0, frame.cols), rng.uniform(0, frame.rows / 2));
+            int r = rng.uniform(3, std::max(4, frame.cols / 40));
+            cv::circle(frame, c, r, cv::Scalar(235, 245, 255), cv::FILLED,
+                       cv::LINE_AA);
+        }
+
+        // Far cargo first so nearer balls overdraw it.
+        std::vector<SyntheticCargo> cargo = scene.cargo;
+        std::sort(cargo.begin(), cargo.end(),
+                  [](const SyntheticCargo& a, const SyntheticCargo& b) {
+                      return a.distance > b.distance;
+                  });
+        for (const auto& ball : cargo) {
+            cv::Point3d centre = FloorPoint(ball.distance, ball.yaw, kCargoRadius);
+            cv::Point2d pixel;
+            if (!Project(centre, pixel)) continue;
+            double range = std::hypot(ball.distance, camera.height - kCargoRadius);
+            int r = static_cast<int>(std::round(fx * kCargoRadius / range));
+            cv::Rect box(static_cast<int>(pixel.x) - r,
+                         static_cast<int>(pixel.y) - r, 2 * r, 2 * r);
+            if ((box & cv::Rect(cv::Point(), camera.size)).area() == 0) continue;
+            cv::Scalar colour = ball.red ? cv::Scalar(40, 40, 190)
+                                         : cv::Scalar(190, 90, 30);
+            cv::circle(frame, pixel, r, colour, cv::FILLED, cv::LINE_AA);
+            cv::circle(frame, pixel - cv::Point2d(r / 3.0, r / 3.0), r / 3,
+                       colour + cv::Scalar::all(50), cv::FILLED, cv::LINE_AA);
+            truth.cargo.push_back({box, ball.red, ball.distance});
+        }
+
+        // Tape strips facing the camera, as flat quads on chords of the rim.
+        cv::Point3d hub = FloorPoint(scene.distance, scene.yaw, kHubHeight);
+
+        // The detector aims at the visible tape, the near side of the
+        // ring, and reports the angles of its pixel in the (pitched)
+        // camera frame, so the truth is taken the same way.
+        double rimDistance = scene.distance - kHubRadius;
+        Project(FloorPoint(rimDistance, scene.yaw, kHubHeight), truth.hubCentre);
+        truth.yaw = std::atan((truth.hubCentre.x - camera.size.width / 2.0) / fx) /
+                    kRadians;
+        truth.pitch =
+                std::atan((camera.size.height / 2.0 - truth.hubCentre.y) / fy) /
+                kRadians;
+        truth.distance = rimDistance;
+        double halfAngle = kStripWidth / 2.0 / kHubRadius;
+        for (int i = 0; i < kStrips; ++i) {
+            double a = 2.0 * CV_PI * i / kStrips;
+            cv::Point2d normal(std::cos(a), std::sin(a));
+            cv::Point2d toCamera(-hub.x - kHubRadius * normal.x,
+                                 -hub.y - kHubRadius * normal.y);
+            if (normal.dot(toCamera) <= 0) continue;
+
+            cv::Point corners[4];
+            bool visible = true;
+            int k = 0;
+            for (double dz : {kStripHeight / 2, -kStripHeight / 2}) {
+                for (double da : {-halfAngle, halfAngle}) {
+                    double edge = dz > 0 ? da : -da;  // keep the quad convex
+                    cv::Point3d p(hub.x + kHubRadius * std::cos(a + edge),
+                                  hub.y + kHubRadius * std::sin(a + edge),
+                                  kHubHeight + dz);
+                    cv::Point2d pixel;
+                    visible = visible && Project(p, pixel);
+                    corners[k++] = cv::Point(static_cast<int>(std::round(pixel.x)),
+                                             static_cast<int>(std::round(pixel.y)));
+                }
+            }
+            if (!visible) continue;
+            cv::fillConvexPoly(frame, corners, 4, cv::Scalar(90, 255, 60),
+                               cv::LINE_AA);
+            cv::Rect box = cv::boundingRect(std::vector<cv::Point>(corners,
+                                                                   corners + 4));
+            box &= cv::Rect(cv::Point(), camera.size);
+            if (box.area() > 0) truth.tapes.push_back(box);
+        }
+
+        if (scene.blur > 0)
+            cv::GaussianBlur(frame, frame, cv::Size(), scene.blur);
+        if (scene.noise > 0) {
+            noise.create(frame.size(), CV_16SC3);
+            rng.fill(noise, cv::RNG::NORMAL, 0, scene.noise);
+            cv::add(frame, noise, frame, cv::noArray(), CV_8U);
+        }
+        return truth;
+    }
+
+    SyntheticScene SyntheticGenerator::RandomScene() {
+        SyntheticScene scene;
+        scene.distance = rng.uniform(1.5, 7.0);
+        scene.yaw = rng.uniform(-0.8, 0.8) * camera.horizontalFov / 2;
+        int balls = rng.uniform(0, 4);
+        for (int i = 0; i < balls; ++i)
+            scene.cargo.push_back({rng.uniform(1.0, 5.0),
+                                   rng.uniform(-0.9, 0.9) * camera.horizontalFov / 2,
+                                   rng.uniform(0, 2) == 0});
+        scene.distractors = rng.uniform(0, 4);
+        scene.noise = rng.uniform(0.0, 12.0);
+        scene.blur = rng.uniform(0.0, 1.5);
+        return scene;
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_SYNTHETICFRAME
+#define TEXASTORQUE_SYNTHETICFRAME
+
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+namespace texastorque {
+    // Pinhole camera matching HubConfig's model: focal lengths from the
+    // field of view, mounted cameraHeight up and pitched cameraPitch
+    // degrees above horizontal.
+    struct SyntheticCamera {
+        cv::Size size{640, 480};
+        double horizontalFov = 62.2;
+        double verticalFov = 48.8;
+        double height = 0.8;
+        double pitch = 30;
+    };
+
+    struct SyntheticCargo {
+        double distance;  // m along the floor
+        double yaw;       // degrees, positive right
+        bool red;
+    };
+
+    // What to draw. The hub centre is placed by its floor distance and
+    // bearing from the camera; everything else is clutter.
+    struct SyntheticScene {
+        double distance = 3;
+        double yaw = 0;
+        std::vector<SyntheticCargo> cargo;
+        int distractors = 0;  // bright lights
+        double noise = 0;     // Gaussian noise std dev, grey levels
+        double blur = 0;      // Gaussian blur sigma, px, 0 = sharp
+    };
+
+    struct CargoTruth {
+        cv::Rect box;
+        bool red;
+        double distance;
+    };
+
+    // Ground truth for a rendered frame, in the pipeline's conventions:
+    // the point of the tape ring nearest the camera, as HubDetector
+    // measures it. yaw and pitch are camera-frame angles of its pixel,
+    // distance is along the floor to it (the hub centre is hubRadius
+    // further).
+    struct SyntheticTruth {
+        double yaw, pitch, distance;
+        cv::Point2d hubCentre;        // the rim point's projection, px
+        std::vector<cv::Rect> tapes;  // visible tape strips
+        std::vector<CargoTruth> cargo;
+    };
+
+    // Renders 2022 hub tape and cargo from a camera pose, for benchmarks
+    // and accuracy checks without a camera or labelled footage.
+    class SyntheticGenerator {
+    public:
+        explicit SyntheticGenerator(const SyntheticCamera& camera =
+                                            SyntheticCamera{},
+                                    uint64_t seed = 2022);
+
+        SyntheticTruth Render(const SyntheticScene& scene, cv::Mat& frame);
+
+        // A plausible match scene: hub 1.5-7 m away within the field of
+        // view, some cargo, lights, noise and blur.
+        SyntheticScene RandomScene();
+
+    private:
+        SyntheticCamera camera;
+        cv::RNG rng;
+        double fx, fy;
+        cv::Mat noise;
+
+        // World: x forward along the floor, y left, z up, camera lens
+        // above the origin. Returns false behind the camera.
+        bool Project(const cv::Point3d& p, cv::Point2d& pixel) const;
+        cv::Point3d FloorPoint(double distance, double yaw, double z) const;
+    };
+}
+
+#endif
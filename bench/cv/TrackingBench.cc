@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// Per-frame cost with and without the tape tracker, on a generated
+// sequence of the hub drifting across a 640x480 frame. detected runs
+// full detection plus the tracker reset every frame; tracked follows
+// the tapes with optical flow and refits the hub, re-detecting only
+// when the track is lost ("lost" per op). Their ratio is the saving on
+// the frames between detections.
+
+#include <vector>
+
+#include "Bench.hh"
+#include "HubDetector.hh"
+#include "Metrics.hh"
+#include "SyntheticFrame.hh"
+#include "TapeTracker.hh"
+
+using namespace texastorque;
+
+namespace {
+    // Hub yaw sweeping 0.3 degrees a frame, there and back, so the
+    // sequence loops without a jump.
+    std::vector<cv::Mat> Sequence() {
+        SyntheticGenerator generator;
+        SyntheticScene scene;
+        scene.distance = 3;
+        scene.noise = 6;
+        std::vector<cv::Mat> frames;
+        for (int i = 0; i < 30; ++i) {
+            scene.yaw = -4.5 + 0.3 * i;
+            frames.emplace_back();
+            generator.Render(scene, frames.back());
+        }
+        for (int i = 28; i > 0; --i) frames.push_back(frames[i]);
+        return frames;
+    }
+
+    void Detected(bench::State& state) {
+        std::vector<cv::Mat> frames = Sequence();
+        HubDetector detector;
+        TrackerConfig config;
+        config.detectEvery = 2;
+        TapeTracker tracker(config);
+        Metrics metrics;
+        Result result;
+        size_t i = 0;
+        while (state.Running()) {
+            const cv::Mat& frame = frames[i++ % frames.size()];
+            detector.Detect(frame, metrics, result);
+            tracker.Reset(frame, result);
+            bench::DoNotOptimize(result);
+        }
+    }
+
+    void Tracked(bench::State& state) {
+        std::vector<cv::Mat> frames = Sequence();
+        HubDetector detector;
+        TrackerConfig config;
+        config.detectEvery = 1 << 30;
+        TapeTracker tracker(config);
+        Metrics metrics;
+        Result result;
+        detector.Detect(frames[0], metrics, result);
+        tracker.Reset(frames[0], result);
+
+        size_t i = 1, ops = 0, lost = 0;
+        while (state.Running()) {
+            const cv::Mat& frame = frames[i++ % frames.size()];
+            if (tracker.Track(frame, result)) {
+                detector.FitHub(frame.size(), result);
+            } else {
+                detector.Detect(frame, metrics, result);
+                tracker.Reset(frame, result);
+                ++lost;
+            }
+            bench::DoNotOptimize(result);
+            ++ops;
+        }
+        state.SetCounter("lost", ops ? double(lost) / ops : 0);
+    }
+}
+
+BENCHMARK("tracking/detected_640x480", Detected);
+BENCHMARK("tracking/tracked_640x480", Tracked);
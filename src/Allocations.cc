@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "Allocations.hh"
+
+namespace texastorque {
+    CountingMatAllocator::CountingMatAllocator()
+            : standard(cv::Mat::getStdAllocator()) {}
+
+    CountingMatAllocator& CountingMatAllocator::Install() {
+        static CountingMatAllocator* allocator = [] {
+            auto* a = new CountingMatAllocator();
+            cv::Mat::setDefaultAllocator(a);
+            return a;
+        }();
+        return *allocator;
+    }
+
+    cv::UMatData* CountingMatAllocator::allocate(
+            int dims, const int* sizes, int type, void* data, size_t* step,
+            int flags, cv::UMatUsageFlags usageFlags) const {
+        cv::UMatData* u = standard->allocate(dims, sizes, type, data, step,
+                                             flags, usageFlags);
+        if (u == nullptr) return u;
+        // Route the free back through us so current usage stays right.
+        u->currAllocator = this;
+        if (data == nullptr) {
+            statistics.onAllocate(u->size);
+            threadAllocations.mat++;
+            threadAllocations.matBytes += u->size;
+        }
+        return u;
+    }
+
+    bool CountingMatAllocator::allocate(cv::UMatData* data, int accessflags,
+                                        cv::UMatUsageFlags usageFlags) const {
+        return standard->allocate(data, accessflags, usageFlags);
+    }
+
+    void CountingMatAllocator::deallocate(cv::UMatData* data) const {
+        if (data == nullptr) return;
+        if (!(data->flags & cv::UMatData::USER_ALLOCATED))
+            statistics.onFree(data->size);
+        standard->deallocate(data);
+    }
+}
@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_ALLOCATIONS
+#define TEXASTORQUE_ALLOCATIONS
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "opencv2/core.hpp"
+#include "opencv2/core/utils/allocator_stats.impl.hpp"
+
+namespace texastorque {
+    // Allocations made so far by one thread: operator new calls (which
+    // include the UMatData header of every Mat) and Mat pixel buffers.
+    struct AllocationCounts {
+        uint64_t heap = 0;
+        uint64_t heapBytes = 0;
+        uint64_t mat = 0;
+        uint64_t matBytes = 0;
+
+        bool Any() const {
+            return heap != 0 || mat != 0;
+        }
+    };
+
+    // Constant-initialised, so safe to touch from operator new at any
+    // point in a thread's life.
+    inline thread_local AllocationCounts threadAllocations;
+
+    // Called from the global operator new (AllocationHook.cc, or the
+    // benchmark's own).
+    inline void CountHeapAllocation(std::size_t bytes) {
+        threadAllocations.heap++;
+        threadAllocations.heapBytes += bytes;
+    }
+
+    // Allocation totals for one stage, added by the timing thread and
+    // read from anywhere.
+    struct AllocationTotals {
+        std::atomic<uint64_t> heap{0};
+        std::atomic<uint64_t> heapBytes{0};
+        std::atomic<uint64_t> mat{0};
+        std::atomic<uint64_t> matBytes{0};
+
+        void Add(const AllocationCounts& start, const AllocationCounts& end) {
+            heap.fetch_add(end.heap - start.heap, std::memory_order_relaxed);
+            heapBytes.fetch_add(end.heapBytes - start.heapBytes,
+                                std::memory_order_relaxed);
+            mat.fetch_add(end.mat - start.mat, std::memory_order_relaxed);
+            matBytes.fetch_add(end.matBytes - start.matBytes,
+                               std::memory_order_relaxed);
+        }
+
+        AllocationCounts Load() const {
+            return {heap.load(std::memory_order_relaxed),
+                    heapBytes.load(std::memory_order_relaxed),
+                    mat.load(std::memory_order_relaxed),
+                    matBytes.load(std::memory_order_relaxed)};
+        }
+    };
+
+    // cv::Mat allocator that counts buffers into threadAllocations and
+    // OpenCV's allocator statistics, then defers to the standard
+    // allocator. Only buffers OpenCV owns are counted, not Mats wrapping
+    // caller memory.
+    class CountingMatAllocator : public cv::MatAllocator {
+    public:
+        // Makes the counting allocator the default for new Mats. It is
+        // never destroyed, since Mats may outlive main().
+        static CountingMatAllocator& Install();
+
+        const cv::utils::AllocatorStatisticsInterface& Statistics() const {
+            return statistics;
+        }
+
+        cv::UMatData* allocate(int dims, const int* sizes, int type, void* data,
+                               size_t* step, int flags,
+                               cv::UMatUsageFlags usageFlags) const override;
+        bool allocate(cv::UMatData* data, int accessflags,
+                      cv::UMatUsageFlags usageFlags) const override;
+        void deallocate(cv::UMatData* data) const override;
+
+    private:
+        CountingMatAllocator();
+
+        cv::MatAllocator* standard;
+        mutable cv::utils::AllocatorStatistics statistics;
+    };
+}
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "BitMask.hh"
+
+#include <algorithm>
+
+namespace texastorque {
+    static inline int CountTrailingZeros(uint64_t w) {
+        return __builtin_ctzll(w);
+    }
+
+    void BitMask::Create(int width, int height) {
+        this->width = width;
+        this->height = height;
+        stride = (width + 63) / 64;
+        bits.resize(static_cast<size_t>(stride) * height);
+    }
+
+    void BitMask::Pack(const cv::Mat& mask) {
+        CV_Assert(mask.type() == CV_8UC1);
+        Create(mask.cols, mask.rows);
+        for (int y = 0; y < height; ++y) {
+            const uint8_t* m = mask.ptr<uint8_t>(y);
+            uint64_t* row = Row(y);
+            for (int i = 0; i < stride; ++i) {
+                int n = std::min(64, width - i * 64);
+                uint64_t w = 0;
+                for (int b = 0; b < n; ++b)
+                    w |= uint64_t(m[b] != 0) << b;
+                row[i] = w;
+                m += 64;
+            }
+        }
+    }
+
+    void BitMask::Unpack(cv::Mat& mask) const {
+        mask.create(height, width, CV_8UC1);
+        for (int y = 0; y < height; ++y) {
+            const uint64_t* row = Row(y);
+            uint8_t* m = mask.ptr<uint8_t>(y);
+            for (int x = 0; x < width; ++x)
+                m[x] = (row[x >> 6] >> (x & 63)) & 1 ? 255 : 0;
+        }
+    }
+
+    uint64_t BitMask::Count() const {
+        uint64_t count = 0;
+        for (uint64_t w : bits) count += __builtin_popcountll(w);
+        return count;
+    }
+
+    // Erode is AND with set pixels beyond the edges, dilate is OR with
+    // clear ones, as OpenCV's default border for each. Horizontal pass
+    // into scratch, then vertical from scratch into dst, so dst may be
+    // src.
+    template <bool kErode>
+    static void Morph(const BitMask& src, BitMask& dst, int size,
+                      BitMask& scratch) {
+        CV_Assert(size >= 1 && size <= kMaxMorphologySize && &scratch != &src &&
+                  &scratch != &dst);
+        const int lo = -(size / 2), hi = size - 1 - size / 2;
+        const uint64_t fill = kErode ? ~uint64_t(0) : 0;
+        const int width = src.Width(), height = src.Height();
+        const int stride = src.Stride();
+        const uint64_t tail = src.TailMask();
+        scratch.Create(width, height);
+
+        for (int y = 0; y < height; ++y) {
+            const uint64_t* row = src.Row(y);
+            uint64_t* out = scratch.Row(y);
+            auto word = [&](int i) {
+                if (i < 0 || i >= stride) return fill;
+                uint64_t w = row[i];
+                if (kErode && i == stride - 1) w |= ~tail;
+                return w;
+            };
+            for (int i = 0; i < stride; ++i) {
+                uint64_t acc = kErode ? ~uint64_t(0) : 0;
+                for (int d = lo; d <= hi; ++d) {
+                    // Bit j of s is source pixel 64 i + j + d.
+                    uint64_t s;
+                    if (d == 0)
+                        s = word(i);
+                    else if (d > 0)
+                        s = (word(i) >> d) | (word(i + 1) << (64 - d));
+                    else
+                        s = (word(i) << -d) | (word(i - 1) >> (64 + d));
+                    acc = kErode ? acc & s : acc | s;
+                }
+                out[i] = acc;
+            }
+            out[stride - 1] &= tail;
+        }
+
+        dst.Create(width, height);
+        for (int y = 0; y < height; ++y) {
+            uint64_t* out = dst.Row(y);
+            int first = std::max(0, y + lo), last = std::min(height - 1, y + hi);
+            const uint64_t* in = scratch.Row(first);
+            std::copy(in, in + stride, out);
+            for (int r = first + 1; r <= last; ++r) {
+                in = scratch.Row(r);
+                for (int i = 0; i < stride; ++i)
+                    out[i] = kErode ? out[i] & in[i] : out[i] | in[i];
+            }
+        }
+    }
+
+    void Erode(const BitMask& src, BitMask& dst, int size, BitMask& scratch) {
+        Morph<true>(src, dst, size, scratch);
+    }
+
+    void Dilate(const BitMask& src, BitMask& dst, int size, BitMask& scratch) {
+        Morph<false>(src, dst, size, scratch);
+    }
+
+    void Open(const BitMask& src, BitMask& dst, int size, BitMask& scratch) {
+        Morph<true>(src, dst, size, scratch);
+        Morph<false>(dst, dst, size, scratch);
+    }
+
+    int BlobFinder::Root(int label) {
+        while (parent[label] != label) {
+            parent[label] = parent[parent[label]];
+            label = parent[label];
+        }
+        return label;
+    }
+
+    const std::vector<Blob>& BlobFinder::Find(const BitMask& mask) {
+        runs.clear();
+        rowStart.clear();
+        parent.clear();
+        blobs.clear();
+
+        const int stride = mask.Stride();
+        for (int y = 0; y < mask.Height(); ++y) {
+            int begin = static_cast<int>(runs.size());
+            rowStart.push_back(begin);
+
+            // Runs of set bits, carried across word boundaries. Bits past
+            // the width are clear, so only a full last word leaves a run
+            // open at the end of the row.
+            const uint64_t* row = mask.Row(y);
+            int open = -1;
+            for (int i = 0; i < stride; ++i) {
+                uint64_t w = row[i];
+                int base = i * 64;
+                if (open >= 0) {
+                    if (w == ~uint64_t(0)) continue;
+                    int end = CountTrailingZeros(~w);
+                    runs.push_back({open, base + end, -1});
+                    open = -1;
+                    w &= ~((uint64_t(1) << end) - 1);
+                }
+                while (w != 0) {
+                    int start = CountTrailingZeros(w);
+                    uint64_t filled = w | ((uint64_t(1) << start) - 1);
+                    if (filled == ~uint64_t(0)) {
+                        open = base + start;
+                        break;
+                    }
+                    int end = CountTrailingZeros(~filled);
+                    runs.push_back({base + start, base + end, -1});
+                    w &= ~((uint64_t(1) << end) - 1);
+                }
+            }
+            if (open >= 0) runs.push_back({open, mask.Width(), -1});
+
+            // Join with the previous row's runs that touch, diagonals
+            // included. Both rows are sorted by x.
+            int end = static_cast<int>(runs.size());
+            int j = y == 0 ? begin : rowStart[y - 1];
+            for (int k = begin; k < end; ++k) {
+                Run& run = runs[k];
+                while (j < begin && runs[j].x1 < run.x0) ++j;
+                for (int p = j; p < begin && runs[p].x0 <= run.x1; ++p) {
+                    int root = Root(runs[p].label);
+                    if (run.label < 0) {
+                        run.label = root;
+                    } else {
+                        int mine = Root(run.label);
+                        if (mine != root)
+                            parent[std::max(mine, root)] = std::min(mine, root);
+                    }
+                }
+                if (run.label < 0) {
+                    run.label = static_cast<int>(parent.size());
+                    parent.push_back(run.label);
+                }
+            }
+        }
+        rowStart.push_back(static_cast<int>(runs.size()));
+
+        blobIndex.assign(parent.size(), -1);
+        for (int y = 0; y < mask.Height(); ++y) {
+            for (int k = rowStart[y]; k < rowStart[y + 1]; ++k) {
+                const Run& run = runs[k];
+                int root = Root(run.label);
+                if (blobIndex[root] < 0) {
+                    blobIndex[root] = static_cast<int>(blobs.size());
+                    blobs.push_back({run.x0, y, run.x1 - 1, y, 0});
+                }
+                Blob& blob = blobs[blobIndex[root]];
+                blob.x0 = std::min(blob.x0, run.x0);
+                blob.x1 = std::max(blob.x1, run.x1 - 1);
+                blob.y1 = y;
+                blob.area += run.x1 - run.x0;
+            }
+        }
+        return blobs;
+    }
+}
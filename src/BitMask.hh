@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_BITMASK
+#define TEXASTORQUE_BITMASK
+
+#include <cstdint>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+namespace texastorque {
+    // Binary mask at one bit per pixel, 64 pixels to a word. Pixel x of
+    // a row is bit x % 64 of word x / 64, and bits past the width are
+    // kept clear so whole words can be counted and compared.
+    class BitMask {
+    public:
+        void Create(int width, int height);
+
+        int Width() const {
+            return width;
+        }
+        int Height() const {
+            return height;
+        }
+        int Stride() const {
+            return stride;
+        }
+        bool Empty() const {
+            return width == 0 || height == 0;
+        }
+
+        uint64_t* Row(int y) {
+            return bits.data() + static_cast<size_t>(y) * stride;
+        }
+        const uint64_t* Row(int y) const {
+            return bits.data() + static_cast<size_t>(y) * stride;
+        }
+
+        // Valid bits of the last word in a row.
+        uint64_t TailMask() const {
+            int used = width % 64;
+            return used == 0 ? ~uint64_t(0) : (uint64_t(1) << used) - 1;
+        }
+
+        // From and to 8-bit 0/non-zero masks.
+        void Pack(const cv::Mat& mask);
+        void Unpack(cv::Mat& mask) const;
+
+        // Set pixels, by popcount.
+        uint64_t Count() const;
+
+    private:
+        int width = 0;
+        int height = 0;
+        int stride = 0;
+        std::vector<uint64_t> bits;
+    };
+
+    // Rectangular size x size erode, dilate and open, matching
+    // cv::erode/dilate/morphologyEx with a MORPH_RECT kernel and the
+    // default anchor and border. Each is a horizontal pass of word shifts
+    // and a vertical pass of word ANDs/ORs over whole rows. dst may be
+    // src; scratch must be neither. size is 1 to kMaxMorphologySize.
+    constexpr int kMaxMorphologySize = 63;
+    void Erode(const BitMask& src, BitMask& dst, int size, BitMask& scratch);
+    void Dilate(const BitMask& src, BitMask& dst, int size, BitMask& scratch);
+    void Open(const BitMask& src, BitMask& dst, int size, BitMask& scratch);
+
+    // Bounding box and pixel count of one 8-connected blob.
+    struct Blob {
+        int x0, y0, x1, y1;  // inclusive
+        int area;
+
+        cv::Rect Rect() const {
+            return cv::Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+        }
+    };
+
+    // Finds 8-connected blobs from the runs of set bits in each packed
+    // row, joining runs that touch the previous row's with union-find.
+    // Unlike findContours(RETR_EXTERNAL), blobs inside another blob's
+    // holes are reported too. Buffers are kept between calls.
+    class BlobFinder {
+    public:
+        const std::vector<Blob>& Find(const BitMask& mask);
+
+    private:
+        struct Run {
+            int x0, x1;  // [x0, x1)
+            int label;
+        };
+
+        std::vector<Run> runs;       // all rows
+        std::vector<int> rowStart;   // first run of each row, plus the end
+        std::vector<int> parent;     // union-find over run labels
+        std::vector<int> blobIndex;
+        std::vector<Blob> blobs;
+
+        int Root(int label);
+    };
+}
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "CargoDetector.hh"
+
+#include <algorithm>
+
+namespace texastorque {
+    CargoDetector::CargoDetector(const CargoConfig& config) : config(config) {
+        if (config.model.empty()) return;
+        net = cv::dnn::readNet(config.model, config.config);
+        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        outputNames = net.getUnconnectedOutLayersNames();
+    }
+
+    void CargoDetector::Detect(const std::vector<cv::Mat>& frames,
+                               const std::vector<cv::Size>& sizes,
+                               std::vector<CargoDetections>& detections) {
+        detections.resize(frames.size());
+        for (auto& d : detections) d.count = 0;
+        if (frames.empty() || !Loaded()) return;
+
+        cv::dnn::blobFromImages(frames, blob, config.scale,
+                                cv::Size(config.inputWidth, config.inputHeight),
+                                config.mean, config.swapRB, false);
+        net.setInput(blob);
+        net.forward(outputs, outputNames);
+
+        if (outputs.size() == 1 && outputs[0].dims == 4 &&
+            outputs[0].size[3] == 7)
+            ParseSsd(outputs[0], sizes, detections);
+        else
+            ParseYolo(sizes, detections);
+    }
+
+    // Rows of [image, label, confidence, x1, y1, x2, y2], normalised;
+    // the network has already suppressed overlaps.
+    void CargoDetector::ParseSsd(const cv::Mat& output,
+                                 const std::vector<cv::Size>& sizes,
+                                 std::vector<CargoDetections>& detections) {
+        const float* row = output.ptr<float>();
+        size_t rows = output.total() / 7;
+        for (size_t i = 0; i < rows; ++i, row += 7) {
+            auto image = static_cast<size_t>(row[0]);
+            if (row[0] < 0 || image >= sizes.size()) continue;
+            if (row[2] < config.minConfidence) continue;
+            const cv::Size& s = sizes[image];
+            int x1 = cvRound(row[3] * s.width), y1 = cvRound(row[4] * s.height);
+            int x2 = cvRound(row[5] * s.width), y2 = cvRound(row[6] * s.height);
+            AddCargo(detections[image], {{x1, y1, x2 - x1, y2 - y1},
+                                         static_cast<int>(row[1]), row[2]});
+        }
+    }
+
+    // Rows of [cx, cy, w, h, objectness, class scores...], normalised,
+    // with each output layer's rows split evenly across the batch.
+    void CargoDetector::ParseYolo(const std::vector<cv::Size>& sizes,
+                                  std::vector<CargoDetections>& detections) {
+        int batch = static_cast<int>(sizes.size());
+        for (int image = 0; image < batch; ++image) {
+            const cv::Size& s = sizes[image];
+            boxes.clear();
+            scores.clear();
+            labels.clear();
+            for (const auto& output : outputs) {
+                if (output.dims != 2 || output.cols <= 5) continue;
+                int perImage = output.rows / batch;
+                for (int r = image * perImage; r < (image + 1) * perImage; ++r) {
+                    const float* row = output.ptr<float>(r);
+                    const float* best = std::max_element(row + 5,
+                                                         row + output.cols);
+                    if (*best < config.minConfidence) continue;
+                    int w = cvRound(row[2] * s.width);
+                    int h = cvRound(row[3] * s.height);
+                    boxes.emplace_back(cvRound(row[0] * s.width) - w / 2,
+                                       cvRound(row[1] * s.height) - h / 2, w, h);
+                    scores.push_back(*best);
+                    labels.push_back(static_cast<int>(best - (row + 5)));
+                }
+            }
+            cv::dnn::NMSBoxes(boxes, scores,
+                              static_cast<float>(config.minConfidence),
+                              static_cast<float>(config.nmsThreshold), keep);
+            for (int i : keep) {
+                const cv::Rect& b = boxes[i];
+                AddCargo(detections[image],
+                         {{b.x, b.y, b.width, b.height}, labels[i], scores[i]});
+            }
+        }
+    }
+
+    void AddCargo(CargoDetections& detections, const Cargo& cargo) {
+        if (detections.count < Result::kMaxCargo) {
+            detections.cargo[detections.count++] = cargo;
+            return;
+        }
+        auto weakest = std::min_element(
+                detections.cargo, detections.cargo + detections.count,
+                [](const Cargo& a, const Cargo& b) {
+                    return a.confidence < b.confidence;
+                });
+        if (weakest->confidence < cargo.confidence) *weakest = cargo;
+    }
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_CARGODETECTOR
+#define TEXASTORQUE_CARGODETECTOR
+
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+#include "opencv2/dnn.hpp"
+
+#include "Realtime.hh"
+#include "Result.hh"
+
+namespace texastorque {
+    // Settings for the learned cargo detector, from the "cargo" section
+    // of frc.json. Detection is off while model is empty.
+    struct CargoConfig {
+        std::string model;   // .caffemodel, .pb, .weights, .onnx, ...
+        std::string config;  // .prototxt, .pbtxt, .cfg, or empty
+        int inputWidth = 300;
+        int inputHeight = 300;
+        double scale = 1.0 / 127.5;
+        cv::Scalar mean{127.5, 127.5, 127.5};
+        bool swapRB = true;
+        double minConfidence = 0.5;
+        double nmsThreshold = 0.4;
+
+        double rate = 10;     // inferences per second
+        double maxAge = 0.3;  // s, older detections are not merged
+        RealtimeConfig realtime;
+    };
+
+    // Detections for one frame, in that frame's pixel coordinates.
+    struct CargoDetections {
+        uint64_t frameTime;
+        int count;
+        Cargo cargo[Result::kMaxCargo];
+    };
+
+    // cv::dnn wrapper for a small single-shot model on the CPU. Handles
+    // SSD-style DetectionOutput ([1, 1, N, 7]) and YOLO region outputs
+    // ([N, 5 + classes] per output layer). Several frames go through
+    // one batched forward pass.
+    class CargoDetector {
+    public:
+        explicit CargoDetector(const CargoConfig& config);
+
+        bool Loaded() const {
+            return !net.empty();
+        }
+
+        // frames are already at the network input size; sizes are the
+        // original frame sizes that boxes are scaled back to.
+        void Detect(const std::vector<cv::Mat>& frames,
+                    const std::vector<cv::Size>& sizes,
+                    std::vector<CargoDetections>& detections);
+
+    private:
+        CargoConfig config;
+        cv::dnn::Net net;
+        std::vector<cv::String> outputNames;
+        cv::Mat blob;
+        std::vector<cv::Mat> outputs;
+
+        std::vector<cv::Rect> boxes;
+        std::vector<float> scores;
+        std::vector<int> labels;
+        std::vector<int> keep;
+
+        void ParseSsd(const cv::Mat& output, const std::vector<cv::Size>& sizes,
+                      std::vector<CargoDetections>& detections);
+        void ParseYolo(const std::vector<cv::Size>& sizes,
+                       std::vector<CargoDetections>& detections);
+    };
+
+    // Adds a detection, replacing the weakest one once the array is full.
+    void AddCargo(CargoDetections& detections, const Cargo& cargo);
+}
+
+#endif
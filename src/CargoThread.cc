@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "CargoThread.hh"
+
+#include <algorithm>
+#include <chrono>
+
+#include "opencv2/imgproc.hpp"
+
+#include "Metrics.hh"
+
+namespace texastorque {
+    // How long a tick waits for cameras to hand over a frame.
+    static constexpr std::chrono::milliseconds kFrameWait(50);
+
+    CargoThread::CargoThread(const CargoConfig& config, int cameras)
+            : config(config), detector(config) {
+        for (int i = 0; i < cameras; ++i)
+            slots.push_back(std::make_unique<Slot>());
+    }
+
+    CargoThread::~CargoThread() {
+        Stop();
+    }
+
+    void CargoThread::Start() {
+        if (thread.joinable() || !detector.Loaded()) return;
+        running = true;
+        thread = std::thread([this] { Run(); });
+    }
+
+    void CargoThread::Stop() {
+        if (!thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        cv.notify_all();
+        thread.join();
+    }
+
+    void CargoThread::Submit(int camera, const cv::Mat& bgr,
+                             uint64_t frameTime) {
+        Slot& slot = *slots[camera];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!slot.wanted.load(std::memory_order_relaxed)) return;
+            cv::resize(bgr, slot.frame,
+                       cv::Size(config.inputWidth, config.inputHeight), 0, 0,
+                       cv::INTER_AREA);
+            slot.size = bgr.size();
+            slot.frameTime = frameTime;
+            slot.fresh = true;
+            slot.wanted.store(false, std::memory_order_relaxed);
+        }
+        cv.notify_all();
+    }
+
+    void CargoThread::Run() {
+        ApplyRealtime(config.realtime, "cargo");
+
+        using Clock = std::chrono::steady_clock;
+        auto next = Clock::now();
+
+        std::vector<cv::Mat> frames;
+        std::vector<cv::Size> sizes;
+        std::vector<int> cameras;
+        std::vector<uint64_t> times;
+        std::vector<CargoDetections> detections;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            for (auto& slot : slots)
+                slot->wanted.store(true, std::memory_order_relaxed);
+            cv.wait_for(lock, kFrameWait, [&] {
+                return !running ||
+                       std::all_of(slots.begin(), slots.end(),
+                                   [](const auto& s) { return s->fresh; });
+            });
+            if (!running) break;
+
+            // Swap frames out so the slots keep their buffers for next time.
+            frames.resize(slots.size());
+            sizes.clear();
+            cameras.clear();
+            times.clear();
+            for (size_t i = 0; i < slots.size(); ++i) {
+                Slot& slot = *slots[i];
+                slot.wanted.store(false, std::memory_order_relaxed);
+                if (!slot.fresh) continue;
+                slot.fresh = false;
+                std::swap(frames[cameras.size()], slot.frame);
+                sizes.push_back(slot.size);
+                times.push_back(slot.frameTime);
+                cameras.push_back(static_cast<int>(i));
+            }
+            frames.resize(cameras.size());
+
+            if (!cameras.empty()) {
+                lock.unlock();
+                int64_t start = MicrosNow();
+                detector.Detect(frames, sizes, detections);
+                int64_t end = MicrosNow();
+                inference.Record(end - start);
+                TraceComplete("cargo_inference", start, end);
+                for (size_t i = 0; i < cameras.size(); ++i) {
+                    detections[i].frameTime = times[i];
+                    slots[cameras[i]]->latest.Store(detections[i]);
+                }
+                lock.lock();
+                for (size_t i = 0; i < cameras.size(); ++i)
+                    std::swap(frames[i], slots[cameras[i]]->frame);
+            }
+
+            // Fixed-rate ticks; a slow inference pushes the schedule back
+            // rather than running several back to back.
+            double rate = config.rate * rateScale.load(std::memory_order_relaxed);
+            next += std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / std::max(rate, 0.1)));
+            auto now = Clock::now();
+            if (next < now) next = now;
+            cv.wait_until(lock, next, [&] { return !running; });
+        }
+    }
+}
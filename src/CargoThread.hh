@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_CARGOTHREAD
+#define TEXASTORQUE_CARGOTHREAD
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "CargoDetector.hh"
+#include "Histogram.hh"
+#include "Seqlock.hh"
+
+namespace texastorque {
+    // Runs the cargo detector on its own (optionally pinned) thread at
+    // config.rate, independent of the camera frame rate. At each tick it
+    // asks every camera for its next frame, waits briefly for them, and
+    // runs whatever arrived as one batch. Vision threads only pay for a
+    // downscale when a frame is actually wanted, and never wait on
+    // inference; they merge the latest detections by timestamp.
+    class CargoThread {
+    public:
+        CargoThread(const CargoConfig& config, int cameras);
+        ~CargoThread();
+
+        CargoThread(const CargoThread&) = delete;
+        CargoThread& operator=(const CargoThread&) = delete;
+
+        void Start();
+        void Stop();
+
+        // Vision thread side. Wants() is a single atomic load.
+        bool Wants(int camera) const {
+            return slots[camera]->wanted.load(std::memory_order_relaxed);
+        }
+        void Submit(int camera, const cv::Mat& bgr, uint64_t frameTime);
+        CargoDetections Latest(int camera) const {
+            return slots[camera]->latest.Load();
+        }
+
+        const CargoConfig& GetConfig() const {
+            return config;
+        }
+
+        // Runs at this fraction of config.rate from the next tick, for
+        // the thermal governor.
+        void SetRateScale(double scale) {
+            rateScale.store(scale, std::memory_order_relaxed);
+        }
+
+        // Forward pass time per batch.
+        Histogram inference;
+
+    private:
+        struct Slot {
+            std::atomic<bool> wanted{false};
+            bool fresh = false;
+            cv::Mat frame;
+            cv::Size size;
+            uint64_t frameTime = 0;
+            Seqlock<CargoDetections> latest;
+        };
+
+        CargoConfig config;
+        CargoDetector detector;
+        std::vector<std::unique_ptr<Slot>> slots;
+        std::atomic<double> rateScale{1.0};
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool running = false;
+        std::thread thread;
+
+        void Run();
+    };
+}
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "ColorLut.hh"
+
+#include <algorithm>
+
+#include "opencv2/imgproc.hpp"
+
+namespace texastorque {
+    ColorLut::ColorLut(const cv::Scalar& lower, const cv::Scalar& upper,
+                       ColorSpace space, int bits)
+            : lower(lower), upper(upper), space(space),
+              bits(ValidLutBits(bits) ? bits : 0), shift(8 - this->bits) {
+        if (this->bits == 0) return;
+
+        // Classify every cell's centre colour with the same conversion
+        // and inRange the direct path uses, then pack the answers.
+        int cells = 1 << (3 * this->bits);
+        int mask = (1 << this->bits) - 1;
+        int centre = shift == 0 ? 0 : 1 << (shift - 1);
+        cv::Mat bgr(1, cells, CV_8UC3);
+        auto* p = bgr.ptr<cv::Vec3b>();
+        for (int i = 0; i < cells; ++i) {
+            p[i][0] = static_cast<uint8_t>(((i >> (2 * this->bits)) << shift) | centre);
+            p[i][1] = static_cast<uint8_t>((((i >> this->bits) & mask) << shift) | centre);
+            p[i][2] = static_cast<uint8_t>(((i & mask) << shift) | centre);
+        }
+        cv::Mat converted, in;
+        cv::cvtColor(bgr, converted, space == ColorSpace::kHsv
+                                             ? cv::COLOR_BGR2HSV
+                                             : cv::COLOR_BGR2YCrCb);
+        cv::inRange(converted, lower, upper, in);
+
+        table.assign((cells + 63) / 64, 0);
+        const uint8_t* m = in.ptr<uint8_t>();
+        for (int i = 0; i < cells; ++i)
+            if (m[i] != 0) table[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+
+    namespace {
+        class ClassifyRows : public cv::ParallelLoopBody {
+        public:
+            ClassifyRows(const ColorLut& lut, const cv::Mat& bgr, cv::Mat& mask)
+                    : lut(lut), bgr(bgr), mask(mask) {}
+
+            void operator()(const cv::Range& rows) const override {
+                for (int y = rows.start; y < rows.end; ++y) {
+                    const uint8_t* p = bgr.ptr<uint8_t>(y);
+                    uint8_t* m = mask.ptr<uint8_t>(y);
+                    for (int x = 0; x < bgr.cols; ++x, p += 3)
+                        m[x] = lut.Contains(p[0], p[1], p[2]) ? 255 : 0;
+                }
+            }
+
+        private:
+            const ColorLut& lut;
+            const cv::Mat& bgr;
+            cv::Mat& mask;
+        };
+
+        class ClassifyPackedRows : public cv::ParallelLoopBody {
+        public:
+            ClassifyPackedRows(const ColorLut& lut, const cv::Mat& bgr,
+                               BitMask& mask)
+                    : lut(lut), bgr(bgr), mask(mask) {}
+
+            void operator()(const cv::Range& rows) const override {
+                for (int y = rows.start; y < rows.end; ++y) {
+                    const uint8_t* p = bgr.ptr<uint8_t>(y);
+                    uint64_t* row = mask.Row(y);
+                    for (int i = 0; i < mask.Stride(); ++i) {
+                        int n = std::min(64, bgr.cols - i * 64);
+                        uint64_t w = 0;
+                        for (int b = 0; b < n; ++b, p += 3)
+                            w |= uint64_t(lut.Contains(p[0], p[1], p[2])) << b;
+                        row[i] = w;
+                    }
+                }
+            }
+
+        private:
+            const ColorLut& lut;
+            const cv::Mat& bgr;
+            BitMask& mask;
+        };
+    }
+
+    void ColorLut::Classify(const cv::Mat& bgr, cv::Mat& mask) const {
+        CV_Assert(HasTable() && bgr.type() == CV_8UC3);
+        mask.create(bgr.size(), CV_8UC1);
+        cv::parallel_for_(cv::Range(0, bgr.rows), ClassifyRows(*this, bgr, mask));
+    }
+
+    void ColorLut::Classify(const cv::Mat& bgr, BitMask& mask) const {
+        CV_Assert(HasTable() && bgr.type() == CV_8UC3);
+        mask.Create(bgr.cols, bgr.rows);
+        cv::parallel_for_(cv::Range(0, bgr.rows),
+                          ClassifyPackedRows(*this, bgr, mask));
+    }
+
+    void ColorLutTable::Set(const cv::Scalar& lower, const cv::Scalar& upper,
+                            ColorSpace space, int bits) {
+        luts.Back() = ColorLut(lower, upper, space, bits);
+        luts.Publish();
+    }
+}
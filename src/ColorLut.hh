@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_COLORLUT
+#define TEXASTORQUE_COLORLUT
+
+#include <cstdint>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "BitMask.hh"
+#include "TripleBuffer.hh"
+
+namespace texastorque {
+    // Colour space the threshold ranges are given in.
+    enum class ColorSpace {
+        kHsv,
+        kYCrCb
+    };
+
+    // Table sizes hub.lutBits accepts: none, 32³ (4 KiB) or 64³ (32 KiB).
+    inline bool ValidLutBits(int bits) {
+        return bits == 0 || bits == 5 || bits == 6;
+    }
+
+    // Threshold ranges, plus, when bits is 5 or 6, a bit-packed BGR
+    // membership table with 2^bits cells per channel. A cell is in if
+    // the colour at its centre is in range, so edges are quantised to
+    // 256 >> bits levels. Other values of bits build no table, as does
+    // default construction (empty ranges).
+    class ColorLut {
+    public:
+        ColorLut() = default;
+        ColorLut(const cv::Scalar& lower, const cv::Scalar& upper,
+                 ColorSpace space, int bits);
+
+        const cv::Scalar& Lower() const {
+            return lower;
+        }
+        const cv::Scalar& Upper() const {
+            return upper;
+        }
+        ColorSpace Space() const {
+            return space;
+        }
+        bool HasTable() const {
+            return bits != 0;
+        }
+
+        bool Contains(uint8_t b, uint8_t g, uint8_t r) const {
+            uint32_t i = (uint32_t(b >> shift) << (2 * bits)) |
+                         (uint32_t(g >> shift) << bits) | uint32_t(r >> shift);
+            return (table[i >> 6] >> (i & 63)) & 1;
+        }
+
+        // One table lookup per pixel, straight from BGR into a 0/255 or
+        // packed mask. Needs HasTable().
+        void Classify(const cv::Mat& bgr, cv::Mat& mask) const;
+        void Classify(const cv::Mat& bgr, BitMask& mask) const;
+
+    private:
+        cv::Scalar lower, upper;
+        ColorSpace space = ColorSpace::kHsv;
+        int bits = 0;
+        int shift = 8;
+        std::vector<uint64_t> table;
+    };
+
+    // Publishes rebuilt LUTs to the vision thread like ShooterTable,
+    // through a TripleBuffer: the reader keeps its table for the whole
+    // frame without a lock, however often a new one is published.
+    class ColorLutTable {
+    public:
+        ColorLutTable() = default;
+
+        ColorLutTable(const ColorLutTable&) = delete;
+        ColorLutTable& operator=(const ColorLutTable&) = delete;
+
+        // Builds and publishes a new LUT. Single writer at a time.
+        void Set(const cv::Scalar& lower, const cv::Scalar& upper,
+                 ColorSpace space, int bits);
+
+        // The newest LUT. Single reader; the reference is valid until its
+        // next call.
+        const ColorLut& Current() {
+            luts.Update();
+            return luts.Front();
+        }
+
+    private:
+        TripleBuffer<ColorLut> luts;
+    };
+}
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "DetectionFeed.hh"
+
+#include <algorithm>
+
+#include "wpi/SmallString.h"
+#include "wpi/WebSocketServer.h"
+#include "wpi/raw_ostream.h"
+#include "wpi/uv/Tcp.h"
+
+#include "ResultJson.hh"
+
+namespace uv = wpi::uv;
+
+namespace texastorque {
+    std::shared_ptr<DetectionFeed> DetectionFeed::Create(uv::Loop& loop,
+                                                         unsigned int port) {
+        auto feed = std::make_shared<DetectionFeed>();
+        auto tcp = uv::Tcp::Create(loop);
+        tcp->Bind("", port);
+        std::weak_ptr<DetectionFeed> weak = feed;
+        tcp->connection.connect([srv = tcp.get(), weak] {
+            auto stream = srv->Accept();
+            if (!stream) return;
+            auto server = wpi::WebSocketServer::Create(*stream);
+            server->connected.connect([weak](wpi::StringRef,
+                                             wpi::WebSocket& ws) {
+                auto feed = weak.lock();
+                if (!feed) return;
+                feed->clients.emplace_back(ws.shared_from_this());
+                wpi::outs() << "Detection feed client connected ("
+                            << feed->clients.size() << " total)\n";
+            });
+        });
+        tcp->Listen();
+        wpi::outs() << "Serving detection feed on port " << port << '\n';
+        return feed;
+    }
+
+    void DetectionFeed::Broadcast(wpi::StringRef camera, const Result& result) {
+        if (result.sequence == lastSequence) return;
+        lastSequence = result.sequence;
+
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const std::weak_ptr<wpi::WebSocket>& c) {
+                                         auto ws = c.lock();
+                                         return !ws || !ws->IsOpen();
+                                     }),
+                      clients.end());
+        if (clients.empty()) return;
+
+        wpi::SmallString<512> json;
+        wpi::raw_svector_ostream os(json);
+        WriteResultJson(os, camera, result);
+
+        for (auto& client : clients) {
+            auto ws = client.lock();
+            // Slow clients drop frames instead of queueing them.
+            if (ws->GetStream().GetWriteQueueSize() > 0) continue;
+            uv::Buffer buf = uv::Buffer::Dup(os.str());
+            ws->SendText(buf, [](wpi::MutableArrayRef<uv::Buffer> bufs,
+                                 uv::Error) {
+                for (auto& b : bufs) b.Deallocate();
+            });
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_DETECTIONFEED
+#define TEXASTORQUE_DETECTIONFEED
+
+#include <memory>
+#include <vector>
+
+#include "wpi/StringRef.h"
+#include "wpi/WebSocket.h"
+#include "wpi/uv/Loop.h"
+
+#include "Result.hh"
+
+namespace texastorque {
+    // WebSocket server pushing one compact JSON record per frame, so
+    // dashboards can draw overlays themselves instead of decoding the
+    // annotated MJPEG stream. Lives entirely on the event loop thread.
+    class DetectionFeed : public std::enable_shared_from_this<DetectionFeed> {
+    public:
+        static std::shared_ptr<DetectionFeed> Create(wpi::uv::Loop& loop,
+                                                     unsigned int port);
+
+        void Broadcast(wpi::StringRef camera, const Result& result);
+
+        size_t ClientCount() const {
+            return clients.size();
+        }
+
+    private:
+        std::vector<std::weak_ptr<wpi::WebSocket>> clients;
+        uint64_t lastSequence = 0;
+    };
+}
+
+#endif
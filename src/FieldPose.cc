@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "FieldPose.hh"
+
+#include <cmath>
+#include <mutex>
+
+namespace texastorque {
+    static constexpr double kRadians = M_PI / 180.0;
+
+    void HeadingHistory::Add(uint64_t time, double degrees) {
+        std::scoped_lock lock(mutex);
+        times[head] = time;
+        headings[head] = degrees;
+        head = (head + 1) % kCapacity;
+        if (size < kCapacity) ++size;
+    }
+
+    bool HeadingHistory::Sample(uint64_t time, double& degrees) const {
+        std::scoped_lock lock(mutex);
+        if (size == 0) return false;
+
+        // Walk back from the newest sample to the pair bracketing time.
+        int newer = (head + kCapacity - 1) % kCapacity;
+        if (time >= times[newer]) {
+            degrees = headings[newer];
+            return true;
+        }
+        for (int i = 1; i < size; ++i) {
+            int older = (newer + kCapacity - 1) % kCapacity;
+            if (times[older] <= time) {
+                if (times[newer] == times[older]) {
+                    degrees = headings[newer];
+                    return true;
+                }
+                double t = double(time - times[older]) /
+                           double(times[newer] - times[older]);
+                double delta = std::remainder(headings[newer] - headings[older],
+                                              360.0);
+                degrees = headings[older] + t * delta;
+                return true;
+            }
+            newer = older;
+        }
+        degrees = headings[newer];
+        return true;
+    }
+
+    FieldPose RobotPoseFromHub(const FieldConfig& config, double yaw,
+                               double distance, double heading) {
+        // Camera to hub centre in field coordinates. Yaw is positive to the
+        // right, which is clockwise.
+        double bearing = (heading + config.cameraRotation - yaw) * kRadians;
+        double range = distance + config.hubRadius;
+        double cameraX = config.hubX - range * std::cos(bearing);
+        double cameraY = config.hubY - range * std::sin(bearing);
+
+        // Back from the camera to the robot centre, whose offset is in
+        // robot coordinates.
+        double c = std::cos(heading * kRadians);
+        double s = std::sin(heading * kRadians);
+        return {cameraX - (c * config.cameraX - s * config.cameraY),
+                cameraY - (s * config.cameraX + c * config.cameraY),
+                std::remainder(heading, 360.0)};
+    }
+}
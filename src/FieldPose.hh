@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_FIELDPOSE
+#define TEXASTORQUE_FIELDPOSE
+
+#include <array>
+#include <cstdint>
+
+#include "wpi/mutex.h"
+
+namespace texastorque {
+    // Field geometry from the "field" section of frc.json. Metres and
+    // degrees, WPILib field coordinates (CCW positive).
+    struct FieldConfig {
+        double hubX = 8.2296;
+        double hubY = 4.1148;
+        double hubRadius = 0.678;  // tape ring, the detector measures to it
+
+        // Camera relative to the robot centre.
+        double cameraX = 0;
+        double cameraY = 0;
+        double cameraRotation = 0;
+    };
+
+    // Robot pose on the field, metres and degrees in [-180, 180].
+    struct FieldPose {
+        double x, y, rotation;
+    };
+
+    // Recent gyro headings keyed by local receive time, so a frame can be
+    // paired with the heading at its capture time instead of "now".
+    class HeadingHistory {
+    public:
+        static constexpr int kCapacity = 64;
+
+        void Add(uint64_t time, double degrees);
+
+        // Interpolated heading at time; false if there are no samples.
+        bool Sample(uint64_t time, double& degrees) const;
+
+    private:
+        mutable wpi::mutex mutex;
+        std::array<uint64_t, kCapacity> times{};
+        std::array<double, kCapacity> headings{};
+        int size = 0;
+        int head = 0;
+    };
+
+    // Robot pose that puts the hub at yaw (degrees, positive right) and
+    // floor distance (to the tape ring) from the camera, given the robot
+    // heading in degrees.
+    FieldPose RobotPoseFromHub(const FieldConfig& config, double yaw,
+                               double distance, double heading);
+}
+
+#endif
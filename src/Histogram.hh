@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_HISTOGRAM
+#define TEXASTORQUE_HISTOGRAM
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace texastorque {
+    // Lock-free log2 histogram of microsecond samples. Bucket i holds
+    // samples in [2^(i-1), 2^i) us, bucket 0 holds everything under 1 us.
+    // Written by one thread, read by any.
+    class Histogram {
+    public:
+        static constexpr int kBuckets = 24;
+
+        void Record(int64_t micros) {
+            int bucket = 0;
+            if (micros > 0) {
+                uint64_t v = static_cast<uint64_t>(micros);
+                while (v != 0 && bucket < kBuckets - 1) {
+                    v >>= 1;
+                    ++bucket;
+                }
+            }
+            counts[bucket].fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(1, std::memory_order_relaxed);
+            sum.fetch_add(micros > 0 ? micros : 0, std::memory_order_relaxed);
+            int64_t prev = max.load(std::memory_order_relaxed);
+            while (micros > prev &&
+                   !max.compare_exchange_weak(prev, micros,
+                                              std::memory_order_relaxed)) {}
+        }
+
+        // Upper bound (us) of the bucket holding the given quantile.
+        int64_t Quantile(double q) const {
+            uint64_t n = total.load(std::memory_order_relaxed);
+            if (n == 0) return 0;
+            uint64_t target = static_cast<uint64_t>(q * n);
+            uint64_t seen = 0;
+            for (int i = 0; i < kBuckets; ++i) {
+                seen += counts[i].load(std::memory_order_relaxed);
+                if (seen > target) return UpperBound(i);
+            }
+            return UpperBound(kBuckets - 1);
+        }
+
+        static int64_t UpperBound(int bucket) {
+            return int64_t(1) << bucket;
+        }
+
+        std::vector<double> Counts() const {
+            std::vector<double> out(kBuckets);
+            for (int i = 0; i < kBuckets; ++i)
+                out[i] = counts[i].load(std::memory_order_relaxed);
+            return out;
+        }
+
+        uint64_t Total() const {
+            return total.load(std::memory_order_relaxed);
+        }
+
+        int64_t Sum() const {
+            return sum.load(std::memory_order_relaxed);
+        }
+
+        int64_t Max() const {
+            return max.load(std::memory_order_relaxed);
+        }
+
+        void Reset() {
+            for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<uint64_t>, kBuckets> counts{};
+        std::atomic<uint64_t> total{0};
+        std::atomic<int64_t> sum{0};
+        std::atomic<int64_t> max{0};
+    };
+}
+
+#endif
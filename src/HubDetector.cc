@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "HubDetector.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "opencv2/imgproc.hpp"
+
+namespace texastorque {
+    static constexpr double kDegrees = 180.0 / CV_PI;
+
+    HubDetector::HubDetector(const HubConfig& config) {
+        SetConfig(config);
+    }
+
+    void HubDetector::SetConfig(const HubConfig& config) {
+        this->config = config;
+        if (!ValidLutBits(config.lutBits)) this->config.lutBits = 0;
+        int size = std::min(std::max(1, config.morphologySize),
+                            kMaxMorphologySize);
+        this->config.morphologySize = size;
+        kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(size, size));
+        thresholds.Set(config.lower, config.upper, config.space, config.lutBits);
+    }
+
+    void HubDetector::SetThresholds(const cv::Scalar& lower,
+                                    const cv::Scalar& upper) {
+        thresholds.Set(lower, upper, config.space, config.lutBits);
+    }
+
+    void HubDetector::Detect(const cv::Mat& bgr, Metrics& metrics,
+                             Result& result) {
+        {
+            StageTimer t(metrics, Stage::kConvert);
+            Convert(bgr);
+        }
+        {
+            StageTimer t(metrics, Stage::kThreshold);
+            Threshold();
+        }
+        {
+            StageTimer t(metrics, Stage::kMorphology);
+            Morphology();
+        }
+        {
+            StageTimer t(metrics, Stage::kContours);
+            FindTapes(result);
+        }
+        {
+            StageTimer t(metrics, Stage::kHubFit);
+            FitHub(bgr.size(), result);
+        }
+    }
+
+    // The LUT classifies BGR directly, so there is nothing to convert.
+    void HubDetector::Convert(const cv::Mat& bgr) {
+        if (config.lutBits != 0) {
+            converted = bgr;
+            return;
+        }
+        cv::cvtColor(bgr, converted, config.space == ColorSpace::kHsv
+                                             ? cv::COLOR_BGR2HSV
+                                             : cv::COLOR_BGR2YCrCb);
+    }
+
+    // A packed mask comes straight from the LUT, or is packed from
+    // inRange's output.
+    void HubDetector::Threshold() {
+        const ColorLut& lut = thresholds.Current();
+        if (config.packedMask && lut.HasTable()) {
+            lut.Classify(converted, packed);
+            return;
+        }
+        if (lut.HasTable())
+            lut.Classify(converted, mask);
+        else
+            cv::inRange(converted, lut.Lower(), lut.Upper(), mask);
+        if (config.packedMask) packed.Pack(mask);
+    }
+
+    void HubDetector::Morphology() {
+        if (config.packedMask)
+            Open(packed, packed, std::max(1, config.morphologySize), scratch);
+        else
+            cv::morphologyEx(mask, mask, cv::MORPH_OPEN, kernel);
+    }
+
+    // Keeps the largest tape-shaped blobs (wider than tall).
+    static void AddTape(const cv::Rect& r, const HubConfig& config,
+                        Result& result) {
+        double area = r.area();
+        if (area < config.minArea || area > config.maxArea) return;
+        if (r.width < r.height) return;
+
+        Box box{r.x, r.y, r.width, r.height};
+        if (result.tapeCount < Result::kMaxTapes) {
+            result.tapes[result.tapeCount++] = box;
+            return;
+        }
+        auto smallest = std::min_element(
+                result.tapes, result.tapes + Result::kMaxTapes,
+                [](const Box& a, const Box& b) {
+                    return a.width * a.height < b.width * b.height;
+                });
+        if (smallest->width * smallest->height < area) *smallest = box;
+    }
+
+    void HubDetector::FindTapes(Result& result) {
+        result.tapeCount = 0;
+        if (config.packedMask) {
+            for (const Blob& blob : blobs.Find(packed))
+                AddTape(blob.Rect(), config, result);
+            return;
+        }
+        cv::findContours(mask, contours, cv::RETR_EXTERNAL,
+                         cv::CHAIN_APPROX_SIMPLE);
+        for (const auto& contour : contours)
+            AddTape(cv::boundingRect(contour), config, result);
+    }
+
+    // The visible tapes sit on an arc around the hub rim. Takes the tapes
+    // level with the largest one and uses the centre of their extent as
+    // the hub centre.
+    void HubDetector::FitHub(const cv::Size& size, Result& result) const {
+        result.found = false;
+        result.confidence = 0;
+        if (result.tapeCount == 0) return;
+
+        const Box* seed = std::max_element(
+                result.tapes, result.tapes + result.tapeCount,
+                [](const Box& a, const Box& b) {
+                    return a.width * a.height < b.width * b.height;
+                });
+        double seedY = seed->y + seed->height / 2.0;
+
+        int minX = seed->x, maxX = seed->x + seed->width;
+        double sumY = 0;
+        int count = 0;
+        for (int i = 0; i < result.tapeCount; ++i) {
+            const Box& b = result.tapes[i];
+            double y = b.y + b.height / 2.0;
+            if (std::abs(y - seedY) > 3.0 * seed->height) continue;
+            minX = std::min(minX, b.x);
+            maxX = std::max(maxX, b.x + b.width);
+            sumY += y;
+            ++count;
+        }
+
+        result.centreX = (minX + maxX) / 2.0;
+        result.centreY = sumY / count;
+
+        if (rays) {
+            rays->Lookup(result.centreX, result.centreY, size, result.yaw,
+                         result.pitch);
+        } else {
+            double fx = size.width / 2.0 /
+                        std::tan(config.horizontalFov / 2.0 / kDegrees);
+            double fy = size.height / 2.0 /
+                        std::tan(config.verticalFov / 2.0 / kDegrees);
+            result.yaw = std::atan((result.centreX - size.width / 2.0) / fx) *
+                         kDegrees;
+            result.pitch = std::atan((size.height / 2.0 - result.centreY) / fy) *
+                           kDegrees;
+        }
+
+        double elevation = (config.cameraPitch + result.pitch) / kDegrees;
+        if (elevation <= 0) return;
+        result.distance =
+                (config.hubHeight - config.cameraHeight) / std::tan(elevation);
+        result.confidence = std::min(1.0, count / 4.0);
+        result.found = true;
+    }
+}
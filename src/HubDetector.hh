@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_HUBDETECTOR
+#define TEXASTORQUE_HUBDETECTOR
+
+#include <memory>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "BitMask.hh"
+#include "ColorLut.hh"
+#include "Metrics.hh"
+#include "RayTable.hh"
+#include "Result.hh"
+
+namespace texastorque {
+    // Tunables for finding the upper hub's vision tape, from the "hub"
+    // section of frc.json. Angles in degrees, lengths in metres.
+    struct HubConfig {
+        cv::Scalar lower{55, 100, 80};
+        cv::Scalar upper{95, 255, 255};
+        ColorSpace space = ColorSpace::kHsv;
+        // Classify BGR through a 2^lutBits per channel table (5 or 6)
+        // instead of converting and calling inRange; 0 for the direct path.
+        int lutBits = 0;
+        // Keep the mask at one bit per pixel from threshold to blobs.
+        bool packedMask = false;
+        int morphologySize = 3;
+        double minArea = 15;
+        double maxArea = 4000;
+
+        double horizontalFov = 62.2;
+        double verticalFov = 48.8;
+        double cameraHeight = 0.8;
+        double cameraPitch = 30;
+        double hubHeight = 2.64;
+    };
+
+    // HSV threshold -> open -> contours -> tape cluster -> angles. Scratch
+    // buffers are members so steady-state frames reuse their memory.
+    class HubDetector {
+    public:
+        explicit HubDetector(const HubConfig& config = HubConfig{});
+
+        void SetConfig(const HubConfig& config);
+        const HubConfig& GetConfig() const {
+            return config;
+        }
+
+        // Swaps in new threshold ranges, rebuilding the LUT on the calling
+        // thread. Safe while another thread runs Detect(); GetConfig()
+        // keeps the ranges the detector was configured with.
+        void SetThresholds(const cv::Scalar& lower, const cv::Scalar& upper);
+
+        // Takes yaw and pitch from a calibrated ray table instead of the
+        // field of view. Call before detecting.
+        void SetRays(std::shared_ptr<const RayTable> rays) {
+            this->rays = std::move(rays);
+        }
+
+        // Fills the detection fields of result (not timing/sequence).
+        void Detect(const cv::Mat& bgr, Metrics& metrics, Result& result);
+
+        // Individual kernels, exposed for benchmarking.
+        void Convert(const cv::Mat& bgr);
+        void Threshold();
+        void Morphology();
+        void FindTapes(Result& result);
+        void FitHub(const cv::Size& size, Result& result) const;
+
+        // The thresholded mask, 8-bit or packed as configured.
+        const cv::Mat& Mask() const {
+            return mask;
+        }
+        const BitMask& PackedMask() const {
+            return packed;
+        }
+
+    private:
+        HubConfig config;
+        cv::Mat kernel;
+        ColorLutTable thresholds;
+        std::shared_ptr<const RayTable> rays;
+        cv::Mat converted;  // HSV/YCrCb, or the BGR input itself for a LUT
+        cv::Mat mask;
+        std::vector<std::vector<cv::Point>> contours;
+        BitMask packed;
+        BitMask scratch;
+        BlobFinder blobs;
+    };
+}
+
+#endif
@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <csignal>
 #include <ctime>
 #include <iostream>
 #include <stdexcept>
@@ -14,10 +15,16 @@
 #include "cameraserver/CameraServer.h"
 #include "networktables/NetworkTable.h"
 #include "networktables/NetworkTableInstance.h"
+#include "wpi/Path.h"
 #include "wpi/StringRef.h"
 #include "wpi/json.h"
 #include "wpi/raw_istream.h"
 #include "wpi/raw_ostream.h"
+#include "wpi/uv/Async.h"
+#include "wpi/uv/FsEvent.h"
+#include "wpi/uv/Loop.h"
+#include "wpi/uv/Signal.h"
+#include "wpi/uv/Timer.h"
 #include "vision/VisionPipeline.h"
 #include "vision/VisionRunner.h"
 
@@ -26,19 +33,49 @@
 #include "opencv2/objdetect.hpp"
 #include "opencv2/videoio.hpp"
 
+#include "CargoThread.hh"
+#include "DetectionFeed.hh"
+#include "MetricsServer.hh"
 #include "Pipeline.hh"
+#include "PoseEstimator.hh"
 #include "Setup.hh"
+#include "StreamTelemetry.hh"
+#include "ThermalGovernor.hh"
+#include "Trace.hh"
+#include "VisionThread.hh"
+#include "VisionWatchdog.hh"
 
-cs::VideoSource* getCameraByName(std::vector<cs::VideoSource> cameras, const std::string& name) {
+namespace uv = wpi::uv;
+
+cs::VideoSource* getCameraByName(std::vector<cs::VideoSource>& cameras, const std::string& name) {
     for (auto& camera : cameras) if (camera.GetName() == name) return &camera;
     return nullptr;
 }
 
+// Pushes camera settings from a re-read frc.json onto the running
+// cameras. Anything else (team, ntmode, realtime) needs a restart.
+void ApplyCameraConfigs() {
+    using namespace setup;
+    for (const auto &config: cameraConfigs) {
+        auto camera = getCameraByName(cameras, config.name);
+        if (camera == nullptr) {
+            wpi::errs() << "camera '" << config.name
+                        << "' was added to the config, restart to start it\n";
+            continue;
+        }
+        wpi::outs() << "Reconfiguring camera '" << config.name << "'\n";
+        camera->SetConfigJson(config.config);
+    }
+}
+
 int main(int argc, char *argv[]) {
     using namespace texastorque;
     using namespace setup;
 
     if (!ReadConfig()) return EXIT_FAILURE;
+    auto& matAllocator = CountingMatAllocator::Install();
+    if (realtimeConfig.lockMemory) LockMemory();
+    StartParallelPool();
 
     auto ntinst = nt::NetworkTableInstance::GetDefault();
     if (server) {
@@ -53,15 +90,233 @@ int main(int argc, char *argv[]) {
     for (const auto &config: cameraConfigs)
         cameras.emplace_back(StartCamera(config));
 
-    if (cameras.size() < 1) return -1;
+    if (getCameraByName(cameras, "Front") == nullptr) return -1;
+
+    auto loop = uv::Loop::Create();
+
+    std::unique_ptr<VisionThread> vision;
+    std::shared_ptr<VisionWatchdog> watchdog;
+
+    // Each processed frame wakes the loop to fan the result out to
+    // WebSocket clients; wakeups coalesce if the loop falls behind.
+    std::shared_ptr<DetectionFeed> feed;
+    if (feedPort != 0) feed = DetectionFeed::Create(*loop, feedPort);
+    auto frameReady = uv::Async<>::Create(loop);
+    frameReady->wakeup.connect([&] {
+        if (vision && feed)
+            feed->Broadcast("Front", vision->GetPipeline().latest.Load());
+    });
+
+    // The cargo detector outlives vision restarts; each camera gets a
+    // slot in its batch.
+    std::shared_ptr<CargoThread> cargo;
+    if (!cargoConfig.model.empty()) {
+        try {
+            cargo = std::make_shared<CargoThread>(cargoConfig, 1);
+            cargo->Start();
+        } catch (const cv::Exception& e) {
+            wpi::errs() << "could not load cargo model: " << e.what() << '\n';
+            cargo.reset();
+        }
+    }
+
+    // Thermal load shedding; the current limits also apply to every
+    // restarted pipeline.
+    ThermalGovernor governor(
+            thermalConfig,
+            ntinst.GetTable("TexasTorqueVision")->GetSubTable("thermal"));
+    auto applyLimits = [&] {
+        const LoadLimits& limits = governor.Limits();
+        if (vision)
+            vision->GetPipeline().SetStreamLimits(limits.streamDivisor,
+                                                  limits.streamScale);
+        if (cargo) cargo->SetRateScale(limits.cargoRate);
+    };
+
+    // The debug stream and its MJPEG server are created once, so a
+    // restarted pipeline keeps streaming on the same port.
+    cs::CvSource output =
+            frc::CameraServer::GetInstance()->PutVideo("Front", 640, 480);
+
+    auto startVision = [&] {
+        vision = std::make_unique<VisionThread>(
+                "Front", *getCameraByName(cameras, "Front"), output, ntinst,
+                realtimeConfig, pipelineConfig, watchdog,
+                [frameReady, wanted = feed != nullptr] {
+                    if (wanted) frameReady->Send();
+                });
+        if (cargo) vision->GetPipeline().SetCargo(cargo, 0);
+        applyLimits();
+        vision->Start();
+    };
+
+    auto reopenAndStart = [&] {
+        for (const auto &config: cameraConfigs) {
+            auto camera = getCameraByName(cameras, config.name);
+            if (config.name != "Front" || camera == nullptr) continue;
+            // Release the device before opening it again.
+            *camera = cs::VideoSource{};
+            *camera = StartCamera(config);
+        }
+        startVision();
+    };
+
+    // A stalled or dead vision thread gets torn down together with its
+    // camera, which is reopened from the config before a fresh pipeline
+    // is bound to it. A thread stuck inside Process still owns its
+    // pipeline (stream, NT listeners, shared memory), so it is parked in
+    // wedged and the restart waits until it returns.
+    std::unique_ptr<VisionThread> wedged;
+    watchdog = std::make_shared<VisionWatchdog>(watchdogTimeout, [&] {
+        if (wedged) return;
+        wpi::errs() << "Restarting vision pipeline\n";
+        if (vision && !vision->Stop()) {
+            wpi::errs() << "Vision thread is stuck, restarting once it "
+                        << "returns\n";
+            wedged = std::move(vision);
+            return;
+        }
+        vision.reset();
+        reopenAndStart();
+    });
+    startVision();
+
+    // Clean shutdown on SIGINT/SIGTERM so a restart finds the cameras free.
+    auto shutdown = [&](int signum) {
+        wpi::outs() << "Caught signal " << signum << ", shutting down\n";
+        vision.reset();
+        wedged.reset();
+        cargo.reset();
+        watchdog.reset();
+        cameras.clear();
+        ntinst.Flush();
+        loop->Walk([](uv::Handle& h) { h.Close(); });
+    };
+    for (int signum : {SIGINT, SIGTERM}) {
+        auto sig = uv::Signal::Create(loop);
+        sig->signal.connect(shutdown);
+        sig->Start(signum);
+    }
+
+    // Periodic housekeeping.
+    auto cargoTable = ntinst.GetTable("TexasTorqueVision")->GetSubTable("cargo");
+    auto telemetry = uv::Timer::Create(loop);
+    telemetry->timeout.connect([&] {
+        if (vision) vision->GetPipeline().PublishTelemetry();
+        if (governor.Update(ReadSystemStats())) applyLimits();
+        if (cargo) {
+            cargoTable->GetEntry("inferenceP50").SetDouble(
+                    cargo->inference.Quantile(0.5) / 1000.0);
+            cargoTable->GetEntry("inferenceP99").SetDouble(
+                    cargo->inference.Quantile(0.99) / 1000.0);
+        }
+    });
+    telemetry->Start(uv::Timer::Time{1000}, uv::Timer::Time{1000});
+
+    auto health = ntinst.GetTable("TexasTorqueVision")->GetSubTable("Front");
+    auto watchdogTimer = uv::Timer::Create(loop);
+    watchdogTimer->timeout.connect([&] {
+        if (!watchdog) return;
+        if (wedged && wedged->Finished()) {
+            wedged.reset();
+            reopenAndStart();
+        }
+        watchdog->Check();
+        health->GetEntry("healthy").SetBoolean(!watchdog->IsExpired());
+        health->GetEntry("staleness").SetDouble(watchdog->GetTime());
+    });
+    watchdogTimer->Start(uv::Timer::Time{100}, uv::Timer::Time{100});
+
+    // cscore counts camera and debug stream frames per telemetry period;
+    // each period is compared against the pipeline's own frame count on
+    // the loop, where the pipeline can be reached safely.
+    cs::SetTelemetryPeriod(1.0);
+    StreamTelemetry streamTelemetry(health);
+    auto telemetryReady = uv::Async<>::Create(loop);
+    telemetryReady->wakeup.connect([&] {
+        auto camera = getCameraByName(cameras, "Front");
+        if (!vision || camera == nullptr) return;
+        auto& pipeline = vision->GetPipeline();
+        streamTelemetry.Update(*camera, pipeline.cvSource,
+                               pipeline.metrics.frames.load(),
+                               pipeline.metrics.streamed.load());
+    });
+    cs::VideoListener telemetryListener(
+            [telemetryReady](const cs::VideoEvent&) {
+                telemetryReady->Send();
+            },
+            cs::VideoEvent::kTelemetryUpdated, false);
+
+    // Odometry/vision fusion at a fixed rate, off the vision thread.
+    std::unique_ptr<PoseFusion> fusion;
+    auto fusionTimer = uv::Timer::Create(loop);
+    if (estimatorConfig.rate > 0) {
+        fusion = std::make_unique<PoseFusion>(ntinst, estimatorConfig);
+        fusionTimer->timeout.connect([&] {
+            TraceSpan span("fusion");
+            if (vision) fusion->Step(vision->GetPipeline().latest.Load());
+        });
+        auto period = uv::Timer::Time{
+                static_cast<uint64_t>(1000.0 / estimatorConfig.rate)};
+        fusionTimer->Start(period, period);
+    }
+
+    // Setting trace/enabled starts a trace session; clearing it writes
+    // the session to traceDirectory and publishes the file name.
+    auto traceTable = ntinst.GetTable("TexasTorqueVision")->GetSubTable("trace");
+    auto traceEntry = traceTable->GetEntry("enabled");
+    traceEntry.SetDefaultBoolean(false);
+    traceEntry.AddListener(
+            [traceTable](const nt::EntryNotification& event) {
+                if (!event.value || !event.value->IsBoolean()) return;
+                if (event.value->GetBoolean()) {
+                    if (TraceEnabled()) return;
+                    TraceStart();
+                    wpi::outs() << "Tracing started\n";
+                    return;
+                }
+                if (!TraceEnabled()) return;
+                TraceStop();
+                std::string path = traceDirectory + "/trace-" +
+                                   std::to_string(std::time(nullptr)) + ".json";
+                long spans = TraceWrite(path);
+                if (spans < 0) {
+                    wpi::errs() << "could not write trace '" << path << "'\n";
+                    return;
+                }
+                wpi::outs() << "Wrote " << spans << " spans to '" << path
+                            << "'\n";
+                traceTable->GetEntry("file").SetString(path);
+                traceTable->GetEntry("spans").SetDouble(spans);
+            },
+            NT_NOTIFY_NEW | NT_NOTIFY_UPDATE | NT_NOTIFY_LOCAL);
+
+    if (metricsPort != 0) {
+        StartMetricsServer(*loop, metricsPort, [&](wpi::raw_ostream& os) {
+            if (vision) WriteMetrics(os, "Front", vision->GetPipeline().metrics);
+            WriteMatStats(os, matAllocator.Statistics());
+            WriteSystemStats(os, ReadSystemStats());
+        });
+    }
 
-    Pipeline* pipe = new Pipeline("Front", ntinst);
-    std::thread([&] {
-        frc::VisionRunner<Pipeline> runner(
-                *getCameraByName(cameras, "Front"), pipe,
-                [&](Pipeline &pipeline) {});
-        runner.RunForever();
-    }).detach();
+    // The dashboard rewrites frc.json by replacing the file, so watch the
+    // directory and debounce the burst of events that produces.
+    auto reload = uv::Timer::Create(loop);
+    reload->timeout.connect([&] {
+        wpi::outs() << "Config changed, reloading '" << configFile << "'\n";
+        if (!ReadConfig()) return;
+        ApplyCameraConfigs();
+        if (watchdog) watchdog->SetTimeout(watchdogTimeout);
+    });
+    auto configWatch = uv::FsEvent::Create(loop);
+    configWatch->fsEvent.connect([&](const char* filename, int) {
+        if (filename == nullptr ||
+            wpi::sys::path::filename(configFile) != filename)
+            return;
+        reload->Start(uv::Timer::Time{500});
+    });
+    configWatch->Start(wpi::sys::path::parent_path(configFile));
 
-    for (;;) std::this_thread::sleep_for(std::chrono::seconds(10));
+    loop->Run();
+    return EXIT_SUCCESS;
 }
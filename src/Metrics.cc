@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "Metrics.hh"
+
+namespace texastorque {
+    const char* StageName(Stage stage) {
+        switch (stage) {
+            case Stage::kGrab: return "grab";
+            case Stage::kFlip: return "flip";
+            case Stage::kConvert: return "convert";
+            case Stage::kThreshold: return "threshold";
+            case Stage::kMorphology: return "morphology";
+            case Stage::kContours: return "contours";
+            case Stage::kHubFit: return "hub_fit";
+            case Stage::kTrack: return "track";
+            case Stage::kCargo: return "cargo";
+            case Stage::kPublish: return "publish";
+            case Stage::kStream: return "stream";
+            case Stage::kTotal: return "total";
+            default: return "unknown";
+        }
+    }
+
+    const cv::utils::trace::details::Region::LocationStaticStorage&
+    StageLocation(Stage stage) {
+        using cv::utils::trace::details::Region;
+        static Region::LocationExtraData* extra[kStageCount] = {};
+        static const auto locations = [] {
+            std::array<Region::LocationStaticStorage, kStageCount> l;
+            for (int i = 0; i < kStageCount; ++i)
+                l[i] = {&extra[i], StageName(static_cast<Stage>(i)), __FILE__,
+                        __LINE__,
+                        cv::utils::trace::details::REGION_FLAG_APP_CODE};
+            return l;
+        }();
+        return locations[static_cast<int>(stage)];
+    }
+}
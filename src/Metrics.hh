@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_METRICS
+#define TEXASTORQUE_METRICS
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "opencv2/core.hpp"
+#include "opencv2/core/utils/trace.hpp"
+
+#include "Allocations.hh"
+#include "Histogram.hh"
+#include "PerfCounters.hh"
+#include "Trace.hh"
+
+namespace texastorque {
+    // Pipeline stages with their own latency histogram. Add new stages
+    // before kStageCount and give them a name in StageName().
+    enum class Stage {
+        kGrab,
+        kFlip,
+        kConvert,
+        kThreshold,
+        kMorphology,
+        kContours,
+        kHubFit,
+        kTrack,
+        kCargo,
+        kPublish,
+        kStream,
+        kTotal,
+        kStageCount
+    };
+
+    constexpr int kStageCount = static_cast<int>(Stage::kStageCount);
+
+    const char* StageName(Stage stage);
+
+    // OpenCV trace location for a stage, so that with OPENCV_TRACE=1 the
+    // library's own regions nest under our stage names.
+    const cv::utils::trace::details::Region::LocationStaticStorage&
+    StageLocation(Stage stage);
+
+    // Monotonic microseconds for stage timing. Kept off wpi::Now() so the
+    // detection kernels build without wpiutil (e.g. in host benchmarks).
+    inline int64_t MicrosNow() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    // Per-camera performance counters. Written by the vision thread only,
+    // read from the main loop without locking.
+    struct Metrics {
+        std::array<Histogram, kStageCount> stages;
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> streamed{0};  // handed to the debug stream
+        std::atomic<double> fps{0};
+
+        // Hardware counters per stage, collected while counters points
+        // at open counters for the timing thread. pixels is the total
+        // input area, for misses per pixel.
+        std::atomic<const PerfCounters*> counters{nullptr};
+        std::array<PerfTotals, kStageCount> perf;
+        std::atomic<uint64_t> pixels{0};
+
+        // Heap and Mat allocations per stage, and frames that allocated
+        // at all. A warmed-up frame should not.
+        std::array<AllocationTotals, kStageCount> allocations;
+        std::atomic<uint64_t> allocatingFrames{0};
+
+        Histogram& operator[](Stage stage) {
+            return stages[static_cast<int>(stage)];
+        }
+
+        const Histogram& operator[](Stage stage) const {
+            return stages[static_cast<int>(stage)];
+        }
+    };
+
+    // Times a scope into one stage histogram and counts the allocations
+    // it makes, and feeds the trace, an OpenCV trace region and the
+    // hardware counters when those are on.
+    class StageTimer {
+    public:
+        StageTimer(Metrics& metrics, Stage stage)
+                : metrics(metrics), stage(stage), region(StageLocation(stage)),
+                  perf(metrics.counters.load(std::memory_order_relaxed)) {
+            if (perf != nullptr) perf->Read(counters);
+            allocated = threadAllocations;
+            start = MicrosNow();
+        }
+
+        ~StageTimer() {
+            int64_t end = MicrosNow();
+            metrics[stage].Record(end - start);
+            const AllocationCounts& now = threadAllocations;
+            if (now.heap != allocated.heap || now.mat != allocated.mat)
+                metrics.allocations[static_cast<int>(stage)].Add(allocated, now);
+            if (TraceEnabled()) TraceComplete(StageName(stage), start, end);
+            if (perf != nullptr) {
+                PerfSample now;
+                if (perf->Read(now))
+                    metrics.perf[static_cast<int>(stage)].Add(counters, now);
+            }
+        }
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+    private:
+        Metrics& metrics;
+        Stage stage;
+        cv::utils::trace::details::Region region;
+        const PerfCounters* perf;
+        PerfSample counters;
+        AllocationCounts allocated;
+        int64_t start;
+    };
+}
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "MetricsServer.hh"
+
+#include "wpi/HttpServerConnection.h"
+#include "wpi/SmallString.h"
+#include "wpi/uv/Tcp.h"
+
+namespace uv = wpi::uv;
+
+namespace texastorque {
+    namespace {
+        class MetricsConnection
+                : public wpi::HttpServerConnection,
+                  public std::enable_shared_from_this<MetricsConnection> {
+        public:
+            MetricsConnection(std::shared_ptr<uv::Stream> stream,
+                              MetricsSource source)
+                    : HttpServerConnection(stream), source(source) {}
+
+        protected:
+            void ProcessRequest() override {
+                if (m_request.GetMethod() != wpi::HTTP_GET) {
+                    SendError(405, "only GET is supported");
+                    return;
+                }
+                auto url = m_request.GetUrl();
+                if (url != "/metrics" && url != "/") {
+                    SendError(404, "try /metrics");
+                    return;
+                }
+                wpi::SmallString<4096> body;
+                wpi::raw_svector_ostream os(body);
+                source(os);
+                SendResponse(200, "OK", "text/plain; version=0.0.4",
+                             os.str());
+            }
+
+        private:
+            MetricsSource source;
+        };
+    }
+
+    void StartMetricsServer(uv::Loop& loop, unsigned int port,
+                            MetricsSource source) {
+        auto tcp = uv::Tcp::Create(loop);
+        if (!tcp) {
+            wpi::errs() << "could not create metrics socket\n";
+            return;
+        }
+        // Bind and Listen report failures synchronously through error.
+        bool failed = false;
+        tcp->error.connect([&failed, port](uv::Error err) {
+            wpi::errs() << "could not serve metrics on port " << port << ": "
+                        << err.str() << '\n';
+            failed = true;
+        });
+        tcp->Bind("", port);
+        if (!failed) {
+            tcp->connection.connect([srv = tcp.get(), source] {
+                auto stream = srv->Accept();
+                if (!stream) return;
+                auto conn =
+                        std::make_shared<MetricsConnection>(stream, source);
+                stream->SetData(conn);
+            });
+            tcp->Listen();
+        }
+        tcp->error.disconnect_all();
+        if (failed) {
+            tcp->Close();
+            return;
+        }
+        wpi::outs() << "Serving metrics on port " << port << '\n';
+    }
+
+    void WriteMetrics(wpi::raw_ostream& os, wpi::StringRef camera,
+                      const Metrics& metrics) {
+        os << "vision_frames_total{camera=\"" << camera << "\"} "
+           << metrics.frames.load() << '\n';
+        os << "vision_dropped_frames_total{camera=\"" << camera << "\"} "
+           << metrics.dropped.load() << '\n';
+        os << "vision_streamed_frames_total{camera=\"" << camera << "\"} "
+           << metrics.streamed.load() << '\n';
+        os << "vision_fps{camera=\"" << camera << "\"} "
+           << metrics.fps.load() << '\n';
+
+        for (int i = 0; i < kStageCount; ++i) {
+            auto stage = static_cast<Stage>(i);
+            const Histogram& h = metrics[stage];
+            wpi::SmallString<64> labels;
+            (wpi::Twine("camera=\"") + camera + "\",stage=\"" +
+             StageName(stage) + "\"")
+                    .toVector(labels);
+
+            uint64_t cumulative = 0;
+            auto counts = h.Counts();
+            // Buckets exclude their upper bound but le includes it; samples
+            // are whole microseconds, so the largest is one less. The last
+            // bucket is open-ended and only counts towards +Inf.
+            for (int b = 0; b < Histogram::kBuckets - 1; ++b) {
+                cumulative += static_cast<uint64_t>(counts[b]);
+                os << "vision_stage_latency_us_bucket{" << labels << ",le=\""
+                   << Histogram::UpperBound(b) - 1 << "\"} " << cumulative
+                   << '\n';
+            }
+            cumulative += static_cast<uint64_t>(counts[Histogram::kBuckets - 1]);
+            os << "vision_stage_latency_us_bucket{" << labels
+               << ",le=\"+Inf\"} " << cumulative << '\n';
+            os << "vision_stage_latency_us_sum{" << labels << "} " << h.Sum()
+               << '\n';
+            os << "vision_stage_latency_us_count{" << labels << "} "
+               << cumulative << '\n';
+
+            AllocationCounts allocs = metrics.allocations[i].Load();
+            os << "vision_stage_allocations_total{" << labels
+               << ",kind=\"heap\"} " << allocs.heap << '\n';
+            os << "vision_stage_allocations_total{" << labels
+               << ",kind=\"mat\"} " << allocs.mat << '\n';
+            os << "vision_stage_allocated_bytes_total{" << labels
+               << ",kind=\"heap\"} " << allocs.heapBytes << '\n';
+            os << "vision_stage_allocated_bytes_total{" << labels
+               << ",kind=\"mat\"} " << allocs.matBytes << '\n';
+
+            const PerfCounters* counters = metrics.counters.load();
+            if (counters == nullptr) continue;
+            const PerfTotals& totals = metrics.perf[i];
+            for (int e = 0; e < kPerfEventCount; ++e) {
+                auto event = static_cast<PerfEvent>(e);
+                if (!counters->Has(event)) continue;
+                os << "vision_stage_perf_total{" << labels << ",event=\""
+                   << PerfEventName(event) << "\"} " << totals[event] << '\n';
+            }
+            os << "vision_stage_perf_samples_total{" << labels << "} "
+               << totals.samples.load() << '\n';
+            os << "vision_stage_ipc{" << labels << "} " << totals.Ipc()
+               << '\n';
+        }
+        os << "vision_pixels_total{camera=\"" << camera << "\"} "
+           << metrics.pixels.load() << '\n';
+
+        os << "vision_allocating_frames_total{camera=\"" << camera << "\"} "
+           << metrics.allocatingFrames.load() << '\n';
+    }
+
+    void WriteMatStats(wpi::raw_ostream& os,
+                       const cv::utils::AllocatorStatisticsInterface& stats) {
+        os << "opencv_mat_bytes " << stats.getCurrentUsage() << '\n';
+        os << "opencv_mat_peak_bytes " << stats.getPeakUsage() << '\n';
+        os << "opencv_mat_allocated_bytes_total " << stats.getTotalUsage()
+           << '\n';
+        os << "opencv_mat_allocations_total "
+           << stats.getNumberOfAllocations() << '\n';
+    }
+
+    void WriteSystemStats(wpi::raw_ostream& os, const SystemStats& stats) {
+        os << "system_cpu_temperature_celsius " << stats.cpuTemperature
+           << '\n';
+        os << "system_cpu_frequency_mhz " << stats.cpuFrequency << '\n';
+        os << "system_cpu_max_frequency_mhz " << stats.cpuMaxFrequency
+           << '\n';
+        os << "system_memory_total_bytes " << stats.memTotal << '\n';
+        os << "system_memory_available_bytes " << stats.memAvailable << '\n';
+        os << "process_resident_memory_bytes " << stats.processRss << '\n';
+    }
+}
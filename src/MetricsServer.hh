@@ -0,0 +1,38 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_METRICSSERVER
+#define TEXASTORQUE_METRICSSERVER
+
+#include <functional>
+#include <memory>
+
+#include "wpi/StringRef.h"
+#include "wpi/raw_ostream.h"
+#include "wpi/uv/Loop.h"
+
+#include "Metrics.hh"
+#include "SystemStats.hh"
+
+namespace texastorque {
+    // Writes the scrape body; called on the event loop for each request.
+    using MetricsSource = std::function<void(wpi::raw_ostream&)>;
+
+    // Serves GET /metrics in the Prometheus text format from the given
+    // loop. Everything is rendered from atomics on the loop thread, the
+    // vision thread does no extra work per scrape.
+    void StartMetricsServer(wpi::uv::Loop& loop, unsigned int port,
+                            MetricsSource source);
+
+    void WriteMetrics(wpi::raw_ostream& os, wpi::StringRef camera,
+                      const Metrics& metrics);
+    // Live and peak Mat buffer usage from the counting allocator.
+    void WriteMatStats(wpi::raw_ostream& os,
+                       const cv::utils::AllocatorStatisticsInterface& stats);
+    void WriteSystemStats(wpi::raw_ostream& os, const SystemStats& stats);
+}
+
+#endif
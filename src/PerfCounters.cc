@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "PerfCounters.hh"
+
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace texastorque {
+    const char* PerfEventName(PerfEvent event) {
+        switch (event) {
+            case PerfEvent::kCycles: return "cycles";
+            case PerfEvent::kInstructions: return "instructions";
+            case PerfEvent::kL1dMisses: return "l1d_misses";
+            case PerfEvent::kLlcMisses: return "llc_misses";
+            case PerfEvent::kBranchMisses: return "branch_misses";
+            default: return "unknown";
+        }
+    }
+
+    static int OpenEvent(uint32_t type, uint64_t config, int group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(
+                syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+
+    PerfCounters::~PerfCounters() {
+        Close();
+    }
+
+    bool PerfCounters::Open() {
+        if (IsOpen()) return true;
+        constexpr uint64_t kL1dReadMiss =
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const struct {
+            PerfEvent event;
+            uint32_t type;
+            uint64_t config;
+        } events[] = {
+                {PerfEvent::kCycles, PERF_TYPE_HARDWARE,
+                 PERF_COUNT_HW_CPU_CYCLES},
+                {PerfEvent::kInstructions, PERF_TYPE_HARDWARE,
+                 PERF_COUNT_HW_INSTRUCTIONS},
+                {PerfEvent::kL1dMisses, PERF_TYPE_HW_CACHE, kL1dReadMiss},
+                {PerfEvent::kLlcMisses, PERF_TYPE_HARDWARE,
+                 PERF_COUNT_HW_CACHE_MISSES},
+                {PerfEvent::kBranchMisses, PERF_TYPE_HARDWARE,
+                 PERF_COUNT_HW_BRANCH_MISSES},
+        };
+
+        members = 0;
+        for (const auto& e : events) {
+            int fd = OpenEvent(e.type, e.config, leader);
+            if (fd < 0) {
+                if (leader < 0) return false;  // no cycles, no counters
+                continue;
+            }
+            if (leader < 0) leader = fd;
+            fds[static_cast<int>(e.event)] = fd;
+            slot[static_cast<int>(e.event)] = members++;
+        }
+
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+    }
+
+    void PerfCounters::Close() {
+        for (int& fd : fds) {
+            if (fd >= 0 && fd != leader) close(fd);
+            fd = -1;
+        }
+        if (leader >= 0) close(leader);
+        leader = -1;
+        members = 0;
+    }
+
+    bool PerfCounters::Read(PerfSample& sample) const {
+        sample.fill(0);
+        if (!IsOpen()) return false;
+        // PERF_FORMAT_GROUP: the member count, then one value per member.
+        uint64_t buffer[1 + kPerfEventCount];
+        ssize_t n = read(leader, buffer, sizeof(uint64_t) * (1 + members));
+        if (n < static_cast<ssize_t>(sizeof(uint64_t) * (1 + members)))
+            return false;
+        for (int i = 0; i < kPerfEventCount; ++i)
+            if (fds[i] >= 0) sample[i] = buffer[1 + slot[i]];
+        return true;
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_PERFCOUNTERS
+#define TEXASTORQUE_PERFCOUNTERS
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace texastorque {
+    enum class PerfEvent {
+        kCycles,
+        kInstructions,
+        kL1dMisses,
+        kLlcMisses,
+        kBranchMisses,
+        kEventCount
+    };
+
+    constexpr int kPerfEventCount = static_cast<int>(PerfEvent::kEventCount);
+
+    const char* PerfEventName(PerfEvent event);
+
+    using PerfSample = std::array<uint64_t, kPerfEventCount>;
+
+    // Hardware counters for the calling thread (user space only), opened
+    // as one perf_event group so a read is a single syscall. Events the
+    // CPU or kernel does not offer read as zero; if even cycles cannot
+    // be opened (no PMU access, perf_event_paranoid) the counters stay
+    // closed and callers fall back to timing only.
+    class PerfCounters {
+    public:
+        PerfCounters() = default;
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        // Opens counters on the calling thread; reads must come from it.
+        bool Open();
+        void Close();
+
+        bool IsOpen() const {
+            return leader >= 0;
+        }
+
+        bool Has(PerfEvent event) const {
+            return fds[static_cast<int>(event)] >= 0;
+        }
+
+        bool Read(PerfSample& sample) const;
+
+    private:
+        int leader = -1;
+        std::array<int, kPerfEventCount> fds{-1, -1, -1, -1, -1};
+        std::array<int, kPerfEventCount> slot{};  // position in group read
+        int members = 0;
+    };
+
+    // Counter totals for one stage, added by the timing thread and read
+    // from anywhere.
+    struct PerfTotals {
+        std::array<std::atomic<uint64_t>, kPerfEventCount> counts{};
+        std::atomic<uint64_t> samples{0};
+
+        void Add(const PerfSample& start, const PerfSample& end) {
+            for (int i = 0; i < kPerfEventCount; ++i)
+                counts[i].fetch_add(end[i] - start[i], std::memory_order_relaxed);
+            samples.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint64_t operator[](PerfEvent event) const {
+            return counts[static_cast<int>(event)].load(std::memory_order_relaxed);
+        }
+
+        double Ipc() const {
+            uint64_t cycles = (*this)[PerfEvent::kCycles];
+            return cycles == 0 ? 0
+                    : static_cast<double>((*this)[PerfEvent::kInstructions]) /
+                              cycles;
+        }
+    };
+}
+
+#endif
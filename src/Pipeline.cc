@@ -6,19 +6,444 @@
 
 #include "Pipeline.hh"
 
+#include "wpi/timestamp.h"
+
 namespace texastorque { 
     time_t timeNow() {
         return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     }   
 
-    Pipeline::Pipeline(std::string name, nt::NetworkTableInstance& ntinst) {  
-        cvSource = frc::CameraServer::GetInstance()->PutVideo(name, 640, 480);
+    Pipeline::Pipeline(std::string name, nt::NetworkTableInstance& ntinst,
+                       cs::CvSource output, const PipelineConfig& config)
+            : cvSource(output), name(name), ntinst(ntinst), detector(config.hub),
+              tracker(config.tracker), filter(config.filter), field(config.field),
+              shooter(config.shooterStep),
+              movingIterations(config.movingIterations),
+              perfWanted(config.perfCounters) {  
+        stream = std::make_unique<StreamThread>(cvSource, config.stream,
+                                                config.calibration);
+        stream->Start();
+        table = ntinst.GetTable("TexasTorqueVision")->GetSubTable(name);
+        foundEntry = table->GetEntry("found");
+        yawEntry = table->GetEntry("yaw");
+        pitchEntry = table->GetEntry("pitch");
+        distanceEntry = table->GetEntry("distance");
+        latencyEntry = table->GetEntry("latency");
+        filteredEntry = table->GetEntry("filtered");
+        filteredYawEntry = table->GetEntry("yawFiltered");
+        filteredPitchEntry = table->GetEntry("pitchFiltered");
+        filteredDistanceEntry = table->GetEntry("distanceFiltered");
+        confidenceEntry = table->GetEntry("confidence");
+        poseEntry = table->GetEntry("robotPose");
+        poseLatencyEntry = table->GetEntry("robotPoseLatency");
+
+        shooterRpmEntry = table->GetEntry("shooterRpm");
+        hoodAngleEntry = table->GetEntry("hoodAngle");
+        cargoEntry = table->GetEntry("cargo");
+        cargoAgeEntry = table->GetEntry("cargoAge");
+        cargoFlat.reserve(Result::kMaxCargo * 6);
+
+        // Shooter table, tunable over NT as a flat [distance, rpm, hood,
+        // tof, ...] array. Rebuilds happen on the NT callback thread.
+        shooter.Set(config.shooter);
+        shooterTableEntry = ntinst.GetEntry("/TexasTorqueVision/shooter/table");
+        std::vector<double> flat;
+        for (auto& p : config.shooter) {
+            flat.push_back(p.distance);
+            flat.push_back(p.rpm);
+            flat.push_back(p.hood);
+            flat.push_back(p.tof);
+        }
+        shooterTableEntry.SetDefaultDoubleArray(flat);
+        shooterListener = shooterTableEntry.AddListener(
+                [this](const nt::EntryNotification& event) {
+                    if (!event.value || !event.value->IsDoubleArray()) return;
+                    auto values = event.value->GetDoubleArray();
+                    std::vector<ShooterPoint> points;
+                    for (size_t i = 0; i + 3 < values.size(); i += 4)
+                        points.push_back({values[i], values[i + 1],
+                                          values[i + 2], values[i + 3]});
+                    shooter.Set(std::move(points));
+                },
+                NT_NOTIFY_NEW | NT_NOTIFY_UPDATE);
+
+        // Robot-relative chassis velocity [vx, vy] in m/s.
+        movingYawEntry = table->GetEntry("yawMoving");
+        movingDistanceEntry = table->GetEntry("distanceMoving");
+        velocityEntry = ntinst.GetEntry("/TexasTorqueVision/robot/velocity");
+        velocityListener = velocityEntry.AddListener(
+                [this](const nt::EntryNotification& event) {
+                    if (!event.value || !event.value->IsDoubleArray()) return;
+                    auto v = event.value->GetDoubleArray();
+                    if (v.size() < 2) return;
+                    velocity.Store({v[0], v[1], event.value->last_change()});
+                },
+                NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
+                        NT_NOTIFY_LOCAL);
+
+        // The robot publishes its gyro heading (degrees, CCW positive).
+        // Keep a short history keyed by local receive time.
+        headingEntry = ntinst.GetEntry("/TexasTorqueVision/robot/heading");
+        headingListener = headingEntry.AddListener(
+                [this](const nt::EntryNotification& event) {
+                    if (event.value && event.value->IsDouble())
+                        headings.Add(event.value->last_change(),
+                                     event.value->GetDouble());
+                },
+                NT_NOTIFY_IMMEDIATE | NT_NOTIFY_NEW | NT_NOTIFY_UPDATE |
+                        NT_NOTIFY_LOCAL);
+
+        // Hub thresholds [lower0, lower1, lower2, upper0, upper1, upper2]
+        // in the configured colour space. The detector rebuilds its LUT on
+        // the NT callback thread and swaps it in between frames.
+        thresholdsEntry = table->GetEntry("hub/thresholds");
+        const auto& lower = config.hub.lower;
+        const auto& upper = config.hub.upper;
+        thresholdsEntry.SetDefaultDoubleArray(
+                {lower[0], lower[1], lower[2], upper[0], upper[1], upper[2]});
+        thresholdsListener = thresholdsEntry.AddListener(
+                [this](const nt::EntryNotification& event) {
+                    if (!event.value || !event.value->IsDoubleArray()) return;
+                    auto v = event.value->GetDoubleArray();
+                    if (v.size() != 6) return;
+                    detector.SetThresholds(cv::Scalar(v[0], v[1], v[2]),
+                                           cv::Scalar(v[3], v[4], v[5]));
+                },
+                NT_NOTIFY_NEW | NT_NOTIFY_UPDATE);
+
+        if (config.calibration.Valid()) {
+            auto rays = std::make_shared<RayTable>();
+            std::string message;
+            if (rays->Open(config.calibration, config.rayCache, message)) {
+                wpi::outs() << name << " ray table " << message << '\n';
+                detector.SetRays(rays);
+            } else {
+                wpi::errs() << name << " ray table: " << message << '\n';
+            }
+        }
+
+        if (config.shmSlots != 0)
+            sharedExport.Open(config.shmName.empty() ? "/texastorque-" + name
+                                                     : config.shmName,
+                              config.shmSlots, config.shmSlotBytes);
+    }
+
+    Pipeline::~Pipeline() {
+        stream->Stop();
+        headingEntry.RemoveListener(headingListener);
+        shooterTableEntry.RemoveListener(shooterListener);
+        velocityEntry.RemoveListener(velocityListener);
+        thresholdsEntry.RemoveListener(thresholdsListener);
+        // Removing a listener does not wait for a callback that is
+        // already running, and they all capture this.
+        ntinst.WaitForEntryListenerQueue(-1);
+    }
+
+    void Pipeline::Process(cv::Mat& input, uint64_t captureTime) {
+        int64_t entry = wpi::Now();
+        // Counters belong to the thread that opens them, so this waits
+        // for the first frame on the vision thread.
+        if (perfWanted && !perfTried) {
+            perfTried = true;
+            if (perf.Open())
+                metrics.counters = &perf;
+            else
+                wpi::errs() << name << ": perf counters unavailable, "
+                            << "timing only\n";
+        }
+        metrics.pixels.fetch_add(input.total(), std::memory_order_relaxed);
+        if (lastEntry != 0) {
+            int64_t period = entry - lastEntry;
+            if (lastPeriod != 0) jitter.Record(std::abs(period - lastPeriod));
+            lastPeriod = period;
+            CountFrame(period);
+        }
+        lastEntry = entry;
+        if (lastExit != 0) metrics[Stage::kGrab].Record(entry - lastExit);
+        if (lastExitMicros != 0)
+            TraceComplete("grab", lastExitMicros, MicrosNow());
+
+        AllocationCounts frameStart = threadAllocations;
+        {
+            StageTimer total(metrics, Stage::kTotal);
+
+            {
+                // Straight into the stream's buffer, so handing it over
+                // later is free.
+                StageTimer t(metrics, Stage::kFlip);
+                cv::Mat& frame = stream->Frame();
+                cv::flip(input, frame, 0);
+                flipped = frame;
+            }
+
+            Locate();
+            result.sequence++;
+            result.frameTime = captureTime;
+            filter.Update(result);
+            EstimatePose();
+            SolveMoving();
+            LookupShooter();
+            {
+                StageTimer t(metrics, Stage::kCargo);
+                MergeCargo();
+            }
+            result.latency = wpi::Now() - static_cast<int64_t>(captureTime);
+            latest.Store(result);
+            sharedExport.PutFrame(flipped, captureTime);
+            sharedExport.PutResult(result);
+
+            {
+                StageTimer t(metrics, Stage::kPublish);
+                Publish();
+            }
+            // Overlays, scaling and encoding happen on the stream thread.
+            int divisor = streamDivisor.load(std::memory_order_relaxed);
+            if (divisor > 0 && ++streamSkipped >= divisor) {
+                streamSkipped = 0;
+                StageTimer t(metrics, Stage::kStream);
+                stream->Publish(result);
+                metrics.streamed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        const AllocationCounts& frameEnd = threadAllocations;
+        if (frameEnd.heap != frameStart.heap || frameEnd.mat != frameStart.mat)
+            metrics.allocatingFrames.fetch_add(1, std::memory_order_relaxed);
+        metrics.frames.fetch_add(1, std::memory_order_relaxed);
+        lastExit = wpi::Now();
+        lastExitMicros = MicrosNow();
+    }
+
+    // Full detection every few frames; in between, optical flow carries
+    // the tapes forward and only the hub fit is redone.
+    void Pipeline::Locate() {
+        if (tracker.NeedsDetection()) {
+            detector.Detect(flipped, metrics, result);
+            result.tracked = false;
+            if (tracker.Enabled()) {
+                StageTimer t(metrics, Stage::kTrack);
+                tracker.Reset(flipped, result);
+            }
+            return;
+        }
+
+        bool tracked;
+        {
+            StageTimer t(metrics, Stage::kTrack);
+            tracked = tracker.Track(flipped, result);
+        }
+        if (!tracked) {
+            detector.Detect(flipped, metrics, result);
+            result.tracked = false;
+            tracker.Reset(flipped, result);
+            return;
+        }
+        {
+            StageTimer t(metrics, Stage::kHubFit);
+            detector.FitHub(flipped.size(), result);
+        }
+        result.tracked = true;
+        if (!result.found || result.confidence < tracker.MinConfidence())
+            tracker.ForceDetection();
+    }
+
+    void Pipeline::EstimatePose() {
+        result.poseValid = false;
+        double heading;
+        if (!result.found || !headings.Sample(result.frameTime, heading))
+            return;
+
+        FieldPose pose = RobotPoseFromHub(
+                field, result.filtered ? result.filteredYaw : result.yaw,
+                result.filtered ? result.filteredDistance : result.distance,
+                heading);
+        result.poseValid = true;
+        result.poseX = pose.x;
+        result.poseY = pose.y;
+        result.poseRotation = pose.rotation;
+    }
+
+    void Pipeline::SolveMoving() {
+        result.movingValid = false;
+        if (!result.found && !result.filtered) return;
+        const ShooterLut& lut = shooter.Current();
+        if (!lut.HasTof()) return;
+
+        // A velocity older than half a second is treated as standing still.
+        Velocity v = velocity.Load();
+        if (v.time == 0 || result.frameTime > v.time + 500000) v = {0, 0, 0};
+
+        MovingShot shot = SolveMovingShot(
+                lut, result.filtered ? result.filteredYaw : result.yaw,
+                result.filtered ? result.filteredDistance : result.distance,
+                field.hubRadius, v.vx, v.vy, field.cameraRotation,
+                movingIterations);
+        result.movingValid = shot.valid;
+        result.movingYaw = shot.yaw;
+        result.movingDistance = shot.distance;
+        result.movingTof = shot.tof;
+    }
+
+    void Pipeline::LookupShooter() {
+        result.shooterValid = false;
+        if (!result.found && !result.filtered) return;
+        const ShooterLut& lut = shooter.Current();
+        double distance = result.movingValid ? result.movingDistance
+                        : result.filtered    ? result.filteredDistance
+                                             : result.distance;
+        result.shooterValid =
+                lut.Lookup(distance, result.shooterRpm, result.hoodAngle);
+    }
+
+    void Pipeline::SetCargo(std::shared_ptr<CargoThread> cargo, int camera) {
+        this->cargo = cargo;
+        cargoCamera = camera;
+    }
+
+    // Offers this (clean, undrawn) frame if the detector wants one, then
+    // takes its latest detections if they are recent enough.
+    void Pipeline::MergeCargo() {
+        result.cargoCount = 0;
+        if (!cargo) return;
+        if (cargo->Wants(cargoCamera))
+            cargo->Submit(cargoCamera, flipped, result.frameTime);
+
+        CargoDetections detections = cargo->Latest(cargoCamera);
+        auto maxAge = static_cast<uint64_t>(cargo->GetConfig().maxAge * 1e6);
+        if (detections.frameTime == 0 ||
+            result.frameTime > detections.frameTime + maxAge)
+            return;
+        result.cargoCount = detections.count;
+        std::copy(detections.cargo, detections.cargo + detections.count,
+                  result.cargo);
+        result.cargoTime = detections.frameTime;
+    }
+
+    void Pipeline::Publish() {
+        foundEntry.SetBoolean(result.found);
+        if (result.found) {
+            yawEntry.SetDouble(result.yaw);
+            pitchEntry.SetDouble(result.pitch);
+            distanceEntry.SetDouble(result.distance);
+        }
+        filteredEntry.SetBoolean(result.filtered);
+        if (result.filtered) {
+            filteredYawEntry.SetDouble(result.filteredYaw);
+            filteredPitchEntry.SetDouble(result.filteredPitch);
+            filteredDistanceEntry.SetDouble(result.filteredDistance);
+        }
+        confidenceEntry.SetDouble(result.filteredConfidence);
+        if (result.movingValid) {
+            movingYawEntry.SetDouble(result.movingYaw);
+            movingDistanceEntry.SetDouble(result.movingDistance);
+        }
+        if (result.shooterValid) {
+            shooterRpmEntry.SetDouble(result.shooterRpm);
+            hoodAngleEntry.SetDouble(result.hoodAngle);
+        }
+        if (cargo) {
+            // [label, confidence, x, y, width, height] per cargo.
+            cargoFlat.clear();
+            for (int i = 0; i < result.cargoCount; ++i) {
+                const Cargo& c = result.cargo[i];
+                cargoFlat.insert(cargoFlat.end(), {static_cast<double>(c.label),
+                                         c.confidence,
+                                         static_cast<double>(c.box.x),
+                                         static_cast<double>(c.box.y),
+                                         static_cast<double>(c.box.width),
+                                         static_cast<double>(c.box.height)});
+            }
+            cargoEntry.SetDoubleArray(cargoFlat);
+            if (result.cargoCount > 0)
+                cargoAgeEntry.SetDouble(
+                        (result.frameTime - result.cargoTime) / 1000.0);
+        }
+        latencyEntry.SetDouble(result.latency / 1000.0);
+        if (result.poseValid) {
+            // Age of the pose at publish time, so the robot can match it
+            // against its own odometry history.
+            poseEntry.SetDoubleArray(
+                    {result.poseX, result.poseY, result.poseRotation});
+            poseLatencyEntry.SetDouble((wpi::Now() - result.frameTime) / 1000.0);
+        }
+        TraceSpan span("nt_flush");
+        ntinst.Flush();
+    }
+
+    // Tracks the nominal frame period with an average that ignores gaps,
+    // and counts a gap of n periods as n - 1 dropped frames.
+    void Pipeline::CountFrame(int64_t period) {
+        if (averagePeriod == 0 || period < 1.5 * averagePeriod) {
+            averagePeriod = averagePeriod == 0
+                    ? period : 0.95 * averagePeriod + 0.05 * period;
+        } else {
+            auto missed = static_cast<uint64_t>(period / averagePeriod + 0.5);
+            if (missed > 1)
+                metrics.dropped.fetch_add(missed - 1, std::memory_order_relaxed);
+        }
+        if (averagePeriod > 0)
+            metrics.fps.store(1e6 / averagePeriod, std::memory_order_relaxed);
+    }
+
+    // Allocations per frame for each stage over the last telemetry
+    // period, so warm-up allocations drop out after the first second.
+    void Pipeline::PublishAllocations() {
+        uint64_t frames = metrics.frames.load();
+        uint64_t periodFrames = frames - lastAllocationFrames;
+        lastAllocationFrames = frames;
+        if (periodFrames == 0) return;
+        auto allocTable = table->GetSubTable("allocations");
+        for (int i = 0; i < kStageCount; ++i) {
+            AllocationCounts now = metrics.allocations[i].Load();
+            AllocationCounts& last = lastAllocations[i];
+            auto stage = allocTable->GetSubTable(
+                    StageName(static_cast<Stage>(i)));
+            stage->GetEntry("perFrame").SetDouble(
+                    double(now.heap - last.heap + now.mat - last.mat) /
+                    periodFrames);
+            stage->GetEntry("bytesPerFrame").SetDouble(
+                    double(now.heapBytes - last.heapBytes + now.matBytes -
+                           last.matBytes) /
+                    periodFrames);
+            last = now;
+        }
+        allocTable->GetEntry("allocatingFrames")
+                .SetDouble(metrics.allocatingFrames.load());
     }
 
-    void Pipeline::Process(cv::Mat& input) {
-        cv::Mat flipped;
-        cv::flip(input, flipped, 0);
-        cvSource.PutFrame(flipped);  
+    void Pipeline::PublishTelemetry() {
+        if (metrics.counters != nullptr) {
+            auto perfTable = table->GetSubTable("perf");
+            uint64_t frames = metrics.frames.load();
+            double pixelsPerFrame =
+                    frames == 0 ? 0 : double(metrics.pixels.load()) / frames;
+            for (int i = 0; i < kStageCount; ++i) {
+                const PerfTotals& totals = metrics.perf[i];
+                uint64_t samples = totals.samples.load();
+                if (samples == 0 || pixelsPerFrame == 0) continue;
+                auto stage = perfTable->GetSubTable(
+                        StageName(static_cast<Stage>(i)));
+                double pixels = samples * pixelsPerFrame;
+                stage->GetEntry("ipc").SetDouble(totals.Ipc());
+                stage->GetEntry("l1dMissesPerPixel")
+                        .SetDouble(totals[PerfEvent::kL1dMisses] / pixels);
+                stage->GetEntry("llcMissesPerPixel")
+                        .SetDouble(totals[PerfEvent::kLlcMisses] / pixels);
+                stage->GetEntry("branchMissesPerPixel")
+                        .SetDouble(totals[PerfEvent::kBranchMisses] / pixels);
+            }
+        }
+        PublishAllocations();
+        table->GetEntry("jitterHistogram").SetDoubleArray(jitter.Counts());
+        table->GetEntry("jitterP50").SetDouble(jitter.Quantile(0.5));
+        table->GetEntry("jitterP99").SetDouble(jitter.Quantile(0.99));
+        table->GetEntry("jitterMax").SetDouble(jitter.Max());
+        table->GetEntry("streamP50").SetDouble(stream->latency.Quantile(0.5));
+        table->GetEntry("streamP99").SetDouble(stream->latency.Quantile(0.99));
+        if (++publishCount % 10 != 0) return;
+        wpi::outs() << name << " jitter us: p50 " << jitter.Quantile(0.5)
+                    << ", p99 " << jitter.Quantile(0.99) << ", max "
+                    << jitter.Max() << '\n';
     }
 }
 
@@ -8,6 +8,8 @@
 #define TEXASTORQUE_PIPELINE
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <ctime>
 #include <iostream>
@@ -21,22 +23,170 @@
 #include "wpi/json.h"
 #include "wpi/raw_istream.h"
 #include "wpi/raw_ostream.h"
-#include "vision/VisionPipeline.h"
-#include "vision/VisionRunner.h"
 
 #include "opencv2/highgui.hpp"
 #include "opencv2/imgproc.hpp"
 #include "opencv2/objdetect.hpp"
 #include "opencv2/videoio.hpp"
 
+#include "Histogram.hh"
+#include "CargoThread.hh"
+#include "FieldPose.hh"
+#include "HubDetector.hh"
+#include "Metrics.hh"
+#include "Result.hh"
+#include "Seqlock.hh"
+#include "SharedExport.hh"
+#include "ShootOnMove.hh"
+#include "ShooterTable.hh"
+#include "StreamThread.hh"
+#include "TapeTracker.hh"
+#include "TargetFilter.hh"
+
 namespace texastorque {
-    class Pipeline : public frc::VisionPipeline {
+    // Per-camera pipeline settings read from frc.json.
+    struct PipelineConfig {
+        HubConfig hub;
+        TargetFilterConfig filter;
+        FieldConfig field;
+        TrackerConfig tracker;
+
+        // Fixed-point iteration cap for the shoot-on-the-move solve.
+        int movingIterations = 6;
+
+        // Tuned shots and the LUT resolution in metres.
+        std::vector<ShooterPoint> shooter;
+        double shooterStep = 0.01;
+
+        // Shared-memory export, disabled when shmSlots is 0.
+        std::string shmName;
+        uint32_t shmSlots = 0;
+        uint32_t shmSlotBytes = 640 * 480 * 3;
+
+        // Lens calibration for the ray table, cached in rayCache.
+        CameraCalibration calibration;
+        std::string rayCache = "/home/pi";
+
+        // Debug stream scaling, overlays and undistortion.
+        StreamConfig stream;
+
+        // Per-stage hardware counters (profile.perf), if the kernel allows.
+        bool perfCounters = false;
+    };
+
+    class Pipeline {
     public:
         cs::CvSource cvSource;
+        std::shared_ptr<nt::NetworkTable> table;
+
+        // Change in frame-to-frame period, i.e. how late the vision
+        // thread was woken relative to the previous frame.
+        Histogram jitter;
+        Metrics metrics;
 
-        Pipeline(std::string name, nt::NetworkTableInstance& ntinst);
+        // Latest result, readable from any thread.
+        Seqlock<Result> latest;
+
+        // output is the debug stream's source. It is owned by the caller
+        // so the stream and its server outlive pipeline restarts.
+        Pipeline(std::string name, nt::NetworkTableInstance& ntinst,
+                 cs::CvSource output,
+                 const PipelineConfig& config = PipelineConfig{});
+        ~Pipeline();
     
-        void Process(cv::Mat& input) override;
+        // captureTime is the camera's timestamp for the frame (GrabFrame's
+        // return value, wpi::Now() time base).
+        void Process(cv::Mat& input, uint64_t captureTime);
+
+        // Hands frames to a shared cargo detector as this camera. Call
+        // before the vision thread starts.
+        void SetCargo(std::shared_ptr<CargoThread> cargo, int camera);
+
+        // Called off the vision thread to push slow-changing stats.
+        void PublishTelemetry();
+
+        // Sends every divisor-th frame (none for 0) to the debug stream,
+        // shrunk by scale. Safe from any thread.
+        void SetStreamLimits(int divisor, int scale) {
+            streamDivisor.store(divisor, std::memory_order_relaxed);
+            stream->SetScale(scale);
+        }
+
+    private:
+        std::string name;
+        nt::NetworkTableInstance ntinst;
+        HubDetector detector;
+        nt::NetworkTableEntry thresholdsEntry;
+        NT_EntryListener thresholdsListener = 0;
+        TapeTracker tracker;
+        TargetFilter filter;
+        FieldConfig field;
+        HeadingHistory headings;
+        nt::NetworkTableEntry headingEntry;
+        NT_EntryListener headingListener = 0;
+        ShooterTable shooter;
+        nt::NetworkTableEntry shooterTableEntry;
+        NT_EntryListener shooterListener = 0;
+        int movingIterations;
+
+        struct Velocity {
+            double vx, vy;
+            uint64_t time;
+        };
+        Seqlock<Velocity> velocity;
+        nt::NetworkTableEntry velocityEntry;
+        NT_EntryListener velocityListener = 0;
+        SharedExport sharedExport;
+        bool perfWanted;
+        bool perfTried = false;
+        PerfCounters perf;
+        std::shared_ptr<CargoThread> cargo;
+        int cargoCamera = 0;
+        nt::NetworkTableEntry cargoEntry;
+        nt::NetworkTableEntry cargoAgeEntry;
+        std::vector<double> cargoFlat;  // reserved once, reused per frame
+        std::unique_ptr<StreamThread> stream;
+        std::atomic<int> streamDivisor{1};
+        int streamSkipped = 0;
+        cv::Mat flipped;  // aliases stream->Frame() until it is published
+        Result result{};
+
+        nt::NetworkTableEntry foundEntry;
+        nt::NetworkTableEntry yawEntry;
+        nt::NetworkTableEntry pitchEntry;
+        nt::NetworkTableEntry distanceEntry;
+        nt::NetworkTableEntry latencyEntry;
+        nt::NetworkTableEntry filteredEntry;
+        nt::NetworkTableEntry filteredYawEntry;
+        nt::NetworkTableEntry filteredPitchEntry;
+        nt::NetworkTableEntry filteredDistanceEntry;
+        nt::NetworkTableEntry confidenceEntry;
+        nt::NetworkTableEntry poseEntry;
+        nt::NetworkTableEntry poseLatencyEntry;
+        nt::NetworkTableEntry shooterRpmEntry;
+        nt::NetworkTableEntry hoodAngleEntry;
+        nt::NetworkTableEntry movingYawEntry;
+        nt::NetworkTableEntry movingDistanceEntry;
+
+        void CountFrame(int64_t period);
+        void Locate();
+        void EstimatePose();
+        void SolveMoving();
+        void LookupShooter();
+        void MergeCargo();
+        void Publish();
+        void PublishAllocations();
+
+        int64_t lastEntry = 0;
+        int64_t lastPeriod = 0;
+        int64_t lastExit = 0;
+        int64_t lastExitMicros = 0;  // MicrosNow() base, for the trace
+        double averagePeriod = 0;
+        int publishCount = 0;
+
+        // Main loop side, for per-period allocation rates.
+        std::array<AllocationCounts, kStageCount> lastAllocations{};
+        uint64_t lastAllocationFrames = 0;
     };
 }
 
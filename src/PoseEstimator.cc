@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "PoseEstimator.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "wpi/timestamp.h"
+
+namespace texastorque {
+    static constexpr double kRadians = M_PI / 180.0;
+
+    static double WrapAngle(double radians) {
+        return std::remainder(radians, 2 * M_PI);
+    }
+
+    static Matrix3 Diagonal(double a, double b, double c) {
+        return {a, 0, 0, 0, b, 0, 0, 0, c};
+    }
+
+    static Matrix3 Multiply(const Matrix3& a, const Matrix3& b) {
+        Matrix3 out;
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                out[r * 3 + c] = a[r * 3] * b[c] + a[r * 3 + 1] * b[3 + c] +
+                                 a[r * 3 + 2] * b[6 + c];
+        return out;
+    }
+
+    static Matrix3 Add(const Matrix3& a, const Matrix3& b) {
+        Matrix3 out;
+        for (int i = 0; i < 9; ++i) out[i] = a[i] + b[i];
+        return out;
+    }
+
+    static bool Invert(const Matrix3& m, Matrix3& out) {
+        double det = m[0] * (m[4] * m[8] - m[5] * m[7]) -
+                     m[1] * (m[3] * m[8] - m[5] * m[6]) +
+                     m[2] * (m[3] * m[7] - m[4] * m[6]);
+        if (std::abs(det) < 1e-12) return false;
+        double inv = 1.0 / det;
+        out = {(m[4] * m[8] - m[5] * m[7]) * inv,
+               (m[2] * m[7] - m[1] * m[8]) * inv,
+               (m[1] * m[5] - m[2] * m[4]) * inv,
+               (m[5] * m[6] - m[3] * m[8]) * inv,
+               (m[0] * m[8] - m[2] * m[6]) * inv,
+               (m[2] * m[3] - m[0] * m[5]) * inv,
+               (m[3] * m[7] - m[4] * m[6]) * inv,
+               (m[1] * m[6] - m[0] * m[7]) * inv,
+               (m[0] * m[4] - m[1] * m[3]) * inv};
+        return true;
+    }
+
+    PoseEstimator::PoseEstimator(const EstimatorConfig& config)
+            : config(config) {
+        auto& q = config.odometryStdDevs;
+        processNoise = Diagonal(q[0] * q[0], q[1] * q[1], q[2] * q[2]);
+    }
+
+    void PoseEstimator::Reset(const PoseState& pose, uint64_t time) {
+        state = pose;
+        auto& r = config.visionStdDevs;
+        covariance = Diagonal(r[0] * r[0], r[1] * r[1], r[2] * r[2]);
+        size = 0;
+        head = 0;
+        initialized = true;
+        Record(time, PoseState{});
+    }
+
+    // Odometry steps are robot-relative, so they are rotated by the
+    // current heading estimate; the model Jacobian is close enough to
+    // identity at 100 Hz that the covariance just grows by Q.
+    void PoseEstimator::Predict(const PoseState& delta) {
+        double c = std::cos(state.theta), s = std::sin(state.theta);
+        state.x += c * delta.x - s * delta.y;
+        state.y += s * delta.x + c * delta.y;
+        state.theta = WrapAngle(state.theta + delta.theta);
+        covariance = Add(covariance, processNoise);
+    }
+
+    // H = I: K = P (P + R)^-1, x += K (z - x), P = (I - K) P.
+    void PoseEstimator::Correct(const PoseState& measured,
+                                const Matrix3& noise) {
+        Matrix3 s;
+        if (!Invert(Add(covariance, noise), s)) return;
+        Matrix3 gain = Multiply(covariance, s);
+
+        double innovation[3] = {measured.x - state.x, measured.y - state.y,
+                                WrapAngle(measured.theta - state.theta)};
+        state.x += gain[0] * innovation[0] + gain[1] * innovation[1] +
+                   gain[2] * innovation[2];
+        state.y += gain[3] * innovation[0] + gain[4] * innovation[1] +
+                   gain[5] * innovation[2];
+        state.theta = WrapAngle(state.theta + gain[6] * innovation[0] +
+                                gain[7] * innovation[1] +
+                                gain[8] * innovation[2]);
+
+        Matrix3 identityMinusGain;
+        for (int i = 0; i < 9; ++i)
+            identityMinusGain[i] = (i % 4 == 0 ? 1.0 : 0.0) - gain[i];
+        covariance = Multiply(identityMinusGain, covariance);
+    }
+
+    void PoseEstimator::Record(uint64_t time, const PoseState& delta) {
+        history[head] = Snapshot{time, delta, state, covariance};
+        head = (head + 1) % kHistory;
+        if (size < kHistory) ++size;
+    }
+
+    void PoseEstimator::AddOdometry(uint64_t time, const PoseState& odometry) {
+        if (!haveOdometry) {
+            lastOdometry = odometry;
+            haveOdometry = true;
+            return;
+        }
+        // Express the step in the previous odometry frame.
+        double dx = odometry.x - lastOdometry.x;
+        double dy = odometry.y - lastOdometry.y;
+        double c = std::cos(lastOdometry.theta), s = std::sin(lastOdometry.theta);
+        PoseState delta{c * dx + s * dy, -s * dx + c * dy,
+                        WrapAngle(odometry.theta - lastOdometry.theta)};
+        lastOdometry = odometry;
+        if (!initialized) return;
+
+        Predict(delta);
+        Record(time, delta);
+    }
+
+    bool PoseEstimator::AddVision(uint64_t time, const PoseState& measured,
+                                  double confidence) {
+        if (!initialized) {
+            Reset(measured, time);
+            return true;
+        }
+
+        // Find the newest snapshot at or before the capture time.
+        int newest = (head + kHistory - 1) % kHistory;
+        int index = newest;
+        int steps = 0;
+        while (history[index].time > time) {
+            if (++steps >= size) return false;  // older than our history
+            index = (index + kHistory - 1) % kHistory;
+        }
+
+        double scale = 1.0 / std::max(confidence, 0.05);
+        auto& r = config.visionStdDevs;
+        Matrix3 noise = Diagonal(r[0] * r[0] * scale, r[1] * r[1] * scale,
+                                 r[2] * r[2] * scale);
+
+        // Rewind, correct, then replay the odometry recorded since.
+        state = history[index].state;
+        covariance = history[index].covariance;
+        Correct(measured, noise);
+        history[index].state = state;
+        history[index].covariance = covariance;
+        while (index != newest) {
+            index = (index + 1) % kHistory;
+            Predict(history[index].delta);
+            history[index].state = state;
+            history[index].covariance = covariance;
+        }
+        return true;
+    }
+
+    PoseFusion::PoseFusion(nt::NetworkTableInstance ntinst,
+                           const EstimatorConfig& config)
+            : estimator(config) {
+        auto robot = ntinst.GetTable("TexasTorqueVision")->GetSubTable("robot");
+        odometryEntry = robot->GetEntry("odometry");
+        fusedEntry = robot->GetEntry("fusedPose");
+        fusedTimeEntry = robot->GetEntry("fusedPoseTimestamp");
+    }
+
+    void PoseFusion::Step(const Result& latest) {
+        // The robot publishes its odometry pose as [x, y, degrees]. The
+        // value's last_change is local receive time, on the same clock as
+        // frame times.
+        auto value = odometryEntry.GetValue();
+        if (value && value->IsDoubleArray() &&
+            value->last_change() != lastOdometryChange) {
+            auto odometry = value->GetDoubleArray();
+            if (odometry.size() >= 3) {
+                lastOdometryChange = value->last_change();
+                estimator.AddOdometry(
+                        lastOdometryChange,
+                        PoseState{odometry[0], odometry[1],
+                                  odometry[2] * kRadians});
+            }
+        }
+
+        if (latest.sequence != lastSequence && latest.poseValid) {
+            lastSequence = latest.sequence;
+            estimator.AddVision(latest.frameTime,
+                                PoseState{latest.poseX, latest.poseY,
+                                          latest.poseRotation * kRadians},
+                                latest.filteredConfidence > 0
+                                        ? latest.filteredConfidence
+                                        : latest.confidence);
+        }
+
+        if (!estimator.IsInitialized()) return;
+        auto& pose = estimator.Estimate();
+        fusedEntry.SetDoubleArray({pose.x, pose.y, pose.theta / kRadians});
+        fusedTimeEntry.SetDouble(wpi::Now() / 1e6);
+    }
+}
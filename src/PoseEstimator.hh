@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_POSEESTIMATOR
+#define TEXASTORQUE_POSEESTIMATOR
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "networktables/NetworkTable.h"
+#include "networktables/NetworkTableInstance.h"
+
+#include "Result.hh"
+
+namespace texastorque {
+    // x, y in metres, theta in radians, WPILib field coordinates.
+    struct PoseState {
+        double x = 0, y = 0, theta = 0;
+    };
+
+    using Matrix3 = std::array<double, 9>;
+
+    // Standard deviations, metres and radians.
+    struct EstimatorConfig {
+        std::array<double, 3> odometryStdDevs{0.02, 0.02, 0.01};  // per step
+        std::array<double, 3> visionStdDevs{0.3, 0.3, 0.05};
+        double rate = 100;  // Hz
+    };
+
+    // Kalman filter over (x, y, theta) driven by wheel odometry deltas and
+    // corrected by latency-stamped vision poses. Vision measurements are
+    // applied at their capture time by rewinding to the snapshot taken
+    // then and replaying the odometry since, like WPILib's
+    // KalmanFilterLatencyCompensator. Everything lives in fixed arrays.
+    //
+    // frc::SwerveDrivePoseEstimator would be the natural fit, but it needs
+    // Eigen, which is not among the bundled headers.
+    class PoseEstimator {
+    public:
+        static constexpr int kHistory = 128;
+
+        explicit PoseEstimator(const EstimatorConfig& config = EstimatorConfig{});
+
+        void Reset(const PoseState& pose, uint64_t time);
+
+        // Odometry pose as reported by the robot; only the change since
+        // the previous call is used.
+        void AddOdometry(uint64_t time, const PoseState& odometry);
+
+        // Vision pose captured at time, scaled down by confidence (0-1].
+        bool AddVision(uint64_t time, const PoseState& measured,
+                       double confidence);
+
+        const PoseState& Estimate() const {
+            return state;
+        }
+
+        bool IsInitialized() const {
+            return initialized;
+        }
+
+    private:
+        struct Snapshot {
+            uint64_t time;
+            PoseState delta;  // robot-relative odometry step into this one
+            PoseState state;
+            Matrix3 covariance;
+        };
+
+        EstimatorConfig config;
+        Matrix3 processNoise{};
+        PoseState state;
+        Matrix3 covariance{};
+        PoseState lastOdometry;
+        bool haveOdometry = false;
+        bool initialized = false;
+
+        std::array<Snapshot, kHistory> history{};
+        int size = 0;
+        int head = 0;
+
+        void Predict(const PoseState& delta);
+        void Correct(const PoseState& measured, const Matrix3& noise);
+        void Record(uint64_t time, const PoseState& delta);
+    };
+
+    // Runs a PoseEstimator on the main loop at a fixed rate: reads the
+    // robot's odometry from NT, folds in new vision poses and publishes
+    // the fused pose.
+    class PoseFusion {
+    public:
+        PoseFusion(nt::NetworkTableInstance ntinst,
+                   const EstimatorConfig& config);
+
+        void Step(const Result& latest);
+
+    private:
+        PoseEstimator estimator;
+        nt::NetworkTableEntry odometryEntry;
+        nt::NetworkTableEntry fusedEntry;
+        nt::NetworkTableEntry fusedTimeEntry;
+        uint64_t lastOdometryChange = 0;
+        uint64_t lastSequence = 0;
+    };
+}
+
+#endif
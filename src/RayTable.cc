@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "RayTable.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "opencv2/imgproc.hpp"
+
+namespace texastorque {
+    static constexpr double kDegrees = 180.0 / CV_PI;
+    static constexpr uint32_t kRayMagic = 0x54545259;  // "TTRY"
+    static constexpr uint32_t kRayVersion = 1;
+
+    struct RayHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        int32_t width, height, step, columns, rows, reserved;
+    };
+
+    // FNV-1a over everything the table depends on.
+    static uint64_t CalibrationKey(const CameraCalibration& c) {
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&](const void* data, size_t bytes) {
+            auto p = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < bytes; ++i) {
+                hash ^= p[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        int32_t ints[] = {c.size.width, c.size.height, c.step,
+                          static_cast<int32_t>(kRayVersion)};
+        double doubles[] = {c.fx, c.fy, c.cx, c.cy};
+        mix(ints, sizeof(ints));
+        mix(doubles, sizeof(doubles));
+        mix(c.distortion.data(), c.distortion.size() * sizeof(double));
+        return hash;
+    }
+
+    RayTable::~RayTable() {
+        Close();
+    }
+
+    void RayTable::Close() {
+        if (mapped != nullptr) munmap(mapped, mappedBytes);
+        mapped = nullptr;
+        mappedBytes = 0;
+        built.clear();
+        rays = nullptr;
+    }
+
+    void RayTable::Build(const CameraCalibration& c) {
+        Close();
+        width = c.size.width;
+        height = c.size.height;
+        step = std::max(1, c.step);
+        columns = (width + step - 1) / step + 1;
+        rows = (height + step - 1) / step + 1;
+
+        // Grid points are continuous coordinates; OpenCV puts pixel
+        // centres on integers.
+        std::vector<cv::Point2f> pixels, normalized;
+        pixels.reserve(static_cast<size_t>(columns) * rows);
+        for (int r = 0; r < rows; ++r)
+            for (int col = 0; col < columns; ++col)
+                pixels.emplace_back(col * step - 0.5f, r * step - 0.5f);
+        cv::Matx33d matrix(c.fx, 0, c.cx, 0, c.fy, c.cy, 0, 0, 1);
+        cv::undistortPoints(pixels, normalized, matrix, c.distortion,
+                            cv::noArray(), cv::noArray(),
+                            cv::TermCriteria(cv::TermCriteria::COUNT |
+                                                     cv::TermCriteria::EPS,
+                                             100, 1e-9));
+
+        built.resize(normalized.size() * 2);
+        for (size_t i = 0; i < normalized.size(); ++i) {
+            double x = normalized[i].x, y = normalized[i].y;
+            built[2 * i] = static_cast<float>(std::atan(x) * kDegrees);
+            built[2 * i + 1] = static_cast<float>(
+                    std::atan2(-y, std::sqrt(1 + x * x)) * kDegrees);
+        }
+        rays = built.data();
+    }
+
+    bool RayTable::Open(const CameraCalibration& c,
+                        const std::string& directory, std::string& message) {
+        Close();
+        if (!c.Valid()) {
+            message = "calibration is incomplete or invalid";
+            return false;
+        }
+        uint64_t key = CalibrationKey(c);
+        char name[64];
+        std::snprintf(name, sizeof(name), "/rays-%dx%d-%016llx.bin",
+                      c.size.width, c.size.height,
+                      static_cast<unsigned long long>(key));
+        std::string path = directory + name;
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            struct stat st;
+            void* p = MAP_FAILED;
+            if (fstat(fd, &st) == 0 &&
+                static_cast<size_t>(st.st_size) >= sizeof(RayHeader))
+                p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (p != MAP_FAILED) {
+                auto header = static_cast<const RayHeader*>(p);
+                size_t bytes = sizeof(RayHeader) +
+                               size_t(header->columns) * header->rows * 2 *
+                                       sizeof(float);
+                if (header->magic == kRayMagic &&
+                    header->version == kRayVersion && header->key == key &&
+                    static_cast<size_t>(st.st_size) == bytes) {
+                    mapped = p;
+                    mappedBytes = bytes;
+                    width = header->width;
+                    height = header->height;
+                    step = header->step;
+                    columns = header->columns;
+                    rows = header->rows;
+                    rays = reinterpret_cast<const float*>(header + 1);
+                    message = "mapped " + path;
+                    return true;
+                }
+                munmap(p, st.st_size);
+            }
+        }
+
+        // Build, then write next to the final name and rename, so a crash
+        // never leaves a truncated table behind.
+        try {
+            Build(c);
+        } catch (const cv::Exception& e) {
+            Close();
+            message = std::string("could not build: ") + e.what();
+            return false;
+        }
+        RayHeader header{kRayMagic, kRayVersion, key, width, height,
+                         step, columns, rows, 0};
+        std::string temporary = path + ".tmp";
+        FILE* f = std::fopen(temporary.c_str(), "wb");
+        bool written = f != nullptr &&
+                       std::fwrite(&header, sizeof(header), 1, f) == 1 &&
+                       std::fwrite(built.data(), sizeof(float), built.size(),
+                                   f) == built.size();
+        if (f != nullptr && std::fclose(f) != 0) written = false;
+        if (written && std::rename(temporary.c_str(), path.c_str()) == 0) {
+            message = "built " + path;
+        } else {
+            std::remove(temporary.c_str());
+            message = "built in memory, could not write " + path;
+        }
+        return true;
+    }
+
+    void RayTable::Lookup(double x, double y, const cv::Size& frame,
+                          double& yaw, double& pitch) const {
+        double gx = x * width / frame.width / step;
+        double gy = y * height / frame.height / step;
+        gx = std::min(std::max(gx, 0.0), columns - 1.0);
+        gy = std::min(std::max(gy, 0.0), rows - 1.0);
+        int ix = std::min(static_cast<int>(gx), columns - 2);
+        int iy = std::min(static_cast<int>(gy), rows - 2);
+        double tx = gx - ix, ty = gy - iy;
+
+        const float* a = rays + 2 * (static_cast<size_t>(iy) * columns + ix);
+        const float* b = a + 2 * columns;
+        auto lerp = [&](int k) {
+            double top = a[k] + tx * (a[k + 2] - a[k]);
+            double bottom = b[k] + tx * (b[k + 2] - b[k]);
+            return top + ty * (bottom - top);
+        };
+        yaw = lerp(0);
+        pitch = lerp(1);
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_RAYTABLE
+#define TEXASTORQUE_RAYTABLE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+namespace texastorque {
+    // Intrinsics and distortion from an OpenCV calibration, at the
+    // resolution it was taken. Frames at other sizes are scaled to it.
+    struct CameraCalibration {
+        cv::Size size;
+        double fx = 0, fy = 0, cx = 0, cy = 0;
+        std::vector<double> distortion;  // k1, k2, p1, p2[, k3...]
+        int step = 4;                    // grid spacing of the ray table
+
+        bool Valid() const {
+            return size.area() > 0 && fx > 0 && fy > 0 &&
+                   ValidDistortionCount(distortion.size());
+        }
+
+        // The coefficient counts OpenCV accepts (none means no distortion).
+        static bool ValidDistortionCount(size_t count) {
+            return count == 0 || count == 4 || count == 5 || count == 8 ||
+                   count == 12 || count == 14;
+        }
+    };
+
+    // Undistorted yaw and pitch (degrees) of the ray through every step-th
+    // pixel, bilinearly interpolated in between. The grid is cached on
+    // disk keyed by the calibration and memory-mapped on later starts, so
+    // it is only computed once per camera.
+    class RayTable {
+    public:
+        RayTable() = default;
+        ~RayTable();
+
+        RayTable(const RayTable&) = delete;
+        RayTable& operator=(const RayTable&) = delete;
+
+        // Maps the cached table for this calibration from directory, or
+        // builds it and writes it there. Returns false if it could not be
+        // built (an invalid calibration, or OpenCV rejected it); message
+        // says what happened either way.
+        bool Open(const CameraCalibration& calibration,
+                  const std::string& directory, std::string& message);
+
+        // Builds in memory without touching the disk.
+        void Build(const CameraCalibration& calibration);
+
+        bool Valid() const {
+            return rays != nullptr;
+        }
+
+        // x and y in frame pixels, with pixel i spanning [i, i + 1).
+        void Lookup(double x, double y, const cv::Size& frame, double& yaw,
+                    double& pitch) const;
+
+    private:
+        int width = 0, height = 0, step = 1;
+        int columns = 0, rows = 0;
+        const float* rays = nullptr;  // [rows][columns][yaw, pitch]
+        std::vector<float> built;
+        void* mapped = nullptr;
+        size_t mappedBytes = 0;
+
+        void Close();
+    };
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "Realtime.hh"
+
+#include <cerrno>
+#include <cstring>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "opencv2/core.hpp"
+#include "wpi/raw_ostream.h"
+
+namespace texastorque {
+    bool ApplyRealtime(const RealtimeConfig& config, const std::string& name) {
+        bool ok = true;
+        pthread_t self = pthread_self();
+        pthread_setname_np(self, name.substr(0, 15).c_str());
+
+        if (config.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(config.cpu, &set);
+            int err = pthread_setaffinity_np(self, sizeof(set), &set);
+            if (err != 0) {
+                wpi::errs() << name << ": could not pin to cpu " << config.cpu
+                            << ": " << std::strerror(err) << '\n';
+                ok = false;
+            }
+        }
+
+        if (config.priority > 0) {
+            sched_param param{};
+            param.sched_priority = config.priority;
+            int err = pthread_setschedparam(self, SCHED_FIFO, &param);
+            if (err != 0) {
+                wpi::errs() << name << ": could not set SCHED_FIFO priority "
+                            << config.priority << ": " << std::strerror(err)
+                            << '\n';
+                ok = false;
+            }
+        }
+
+        // On Linux niceness is per thread, keyed by the thread id.
+        if (config.nice != 0) {
+            auto tid = static_cast<id_t>(syscall(SYS_gettid));
+            if (setpriority(PRIO_PROCESS, tid, config.nice) != 0) {
+                wpi::errs() << name << ": could not set nice " << config.nice
+                            << ": " << std::strerror(errno) << '\n';
+                ok = false;
+            }
+        }
+
+        if (ok && (config.cpu >= 0 || config.priority > 0 || config.nice != 0))
+            wpi::outs() << name << ": cpu " << config.cpu << ", priority "
+                        << config.priority << ", nice " << config.nice << '\n';
+        return ok;
+    }
+
+    void StartParallelPool() {
+        int threads = cv::getNumberOfCPUs();
+        cv::setNumThreads(threads);
+        // Enough stripes that every worker is needed.
+        cv::parallel_for_(cv::Range(0, threads * 4), [](const cv::Range&) {});
+    }
+
+    bool LockMemory() {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            wpi::errs() << "could not lock memory: " << std::strerror(errno)
+                        << '\n';
+            return false;
+        }
+        wpi::outs() << "Locked process memory\n";
+        return true;
+    }
+}
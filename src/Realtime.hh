@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_REALTIME
+#define TEXASTORQUE_REALTIME
+
+#include <string>
+
+namespace texastorque {
+    // Scheduling settings for a worker thread, read from frc.json.
+    // A cpu of -1 leaves affinity alone, a priority of 0 leaves the
+    // thread on SCHED_OTHER, and a nice of 0 leaves its niceness alone.
+    struct RealtimeConfig {
+        int cpu = -1;
+        int priority = 0;
+        bool lockMemory = false;
+        int nice = 0;
+    };
+
+    // Applies affinity, SCHED_FIFO priority and niceness to the calling
+    // thread.
+    // Failures (usually missing CAP_SYS_NICE) are logged, not fatal.
+    bool ApplyRealtime(const RealtimeConfig& config, const std::string& name);
+
+    // Starts OpenCV's parallel_for_ worker pool from the calling thread.
+    // Workers inherit the affinity and policy of whichever thread creates
+    // them, so call this from main() before any thread is pinned or made
+    // SCHED_FIFO; otherwise they all land on the vision core.
+    void StartParallelPool();
+
+    // mlockall(MCL_CURRENT | MCL_FUTURE) so the vision thread never
+    // takes a page fault mid-frame.
+    bool LockMemory();
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_RESULT
+#define TEXASTORQUE_RESULT
+
+#include <cstdint>
+
+namespace texastorque {
+    struct Box {
+        int x, y, width, height;
+    };
+
+    struct Cargo {
+        Box box;
+        int label;  // model class id
+        float confidence;
+    };
+
+    // Everything the pipeline knows about one frame. Kept trivially
+    // copyable and fixed-size so it can be handed between threads (and
+    // processes) by plain copy.
+    struct Result {
+        static constexpr int kMaxTapes = 8;
+        static constexpr int kMaxCargo = 8;
+
+        uint64_t sequence;
+        uint64_t frameTime;  // us, capture time, wpi::Now() time base
+        int64_t latency;     // us from capture to result
+
+        bool found;
+        int tapeCount;
+        Box tapes[kMaxTapes];
+
+        double centreX, centreY;  // px
+        double yaw, pitch;        // degrees, positive right / up
+        double distance;          // m, camera to hub centre along floor
+        double confidence;        // 0 to 1
+
+        // Temporally filtered copies of the above. filtered stays true
+        // through short dropouts, holding the last filtered values.
+        bool filtered;
+        double filteredYaw, filteredPitch, filteredDistance;
+        double filteredConfidence;
+
+        // Field-relative robot pose from the hub and the gyro heading at
+        // frameTime. Metres and degrees, WPILib field coordinates.
+        bool poseValid;
+        double poseX, poseY, poseRotation;
+
+        // Aim point compensated for robot velocity over the ball's time
+        // of flight; same conventions as yaw/distance.
+        bool movingValid;
+        double movingYaw, movingDistance, movingTof;
+
+        // Shooter setpoints for the moving (else filtered) distance.
+        bool shooterValid;
+        double shooterRpm, hoodAngle;
+
+        // Tapes were carried forward by optical flow rather than detected.
+        bool tracked;
+
+        // Latest cargo from the learned detector, which runs slower than
+        // this pipeline. cargoTime is the frameTime it was detected on.
+        int cargoCount;
+        Cargo cargo[kMaxCargo];
+        uint64_t cargoTime;
+    };
+}
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_RESULTJSON
+#define TEXASTORQUE_RESULTJSON
+
+#include <cstdio>
+
+#include "Result.hh"
+
+namespace texastorque {
+    // Fixed-point number for streaming, formatted without allocating.
+    class Fixed {
+    public:
+        Fixed(double value, int digits) {
+            std::snprintf(text, sizeof(text), "%.*f", digits, value);
+        }
+
+        const char* c_str() const {
+            return text;
+        }
+
+    private:
+        char text[32];
+    };
+
+    template <typename Stream>
+    Stream& operator<<(Stream& os, const Fixed& value) {
+        os << value.c_str();
+        return os;
+    }
+
+    // {"camera":..,"seq":..,"t":..,"latency":..,"found":..,"cx":..,"cy":..,
+    //  "yaw":..,"pitch":..,"distance":..,"confidence":..,"tapes":[[x,y,w,h]]}
+    // Header-only and generic over the stream (wpi::raw_ostream on the
+    // Pi) so serialization can be benchmarked without wpiutil.
+    template <typename Stream, typename Name>
+    void WriteResultJson(Stream& os, const Name& camera, const Result& result) {
+        os << "{\"camera\":\"" << camera << "\",\"seq\":" << result.sequence
+           << ",\"t\":" << result.frameTime << ",\"latency\":"
+           << result.latency << ",\"found\":"
+           << (result.found ? "true" : "false");
+        if (result.found) {
+            os << ",\"cx\":" << Fixed(result.centreX, 1)
+               << ",\"cy\":" << Fixed(result.centreY, 1)
+               << ",\"yaw\":" << Fixed(result.yaw, 3)
+               << ",\"pitch\":" << Fixed(result.pitch, 3)
+               << ",\"distance\":" << Fixed(result.distance, 3)
+               << ",\"confidence\":" << Fixed(result.confidence, 2)
+               << ",\"tracked\":" << (result.tracked ? "true" : "false");
+        }
+        if (result.filtered) {
+            os << ",\"fyaw\":" << Fixed(result.filteredYaw, 3)
+               << ",\"fpitch\":" << Fixed(result.filteredPitch, 3)
+               << ",\"fdistance\":" << Fixed(result.filteredDistance, 3)
+               << ",\"fconfidence\":" << Fixed(result.filteredConfidence, 2);
+        }
+        if (result.movingValid) {
+            os << ",\"myaw\":" << Fixed(result.movingYaw, 3)
+               << ",\"mdistance\":" << Fixed(result.movingDistance, 3);
+        }
+        if (result.shooterValid) {
+            os << ",\"rpm\":" << Fixed(result.shooterRpm, 0)
+               << ",\"hood\":" << Fixed(result.hoodAngle, 2);
+        }
+        os << ",\"tapes\":[";
+        for (int i = 0; i < result.tapeCount; ++i) {
+            const Box& b = result.tapes[i];
+            if (i != 0) os << ',';
+            os << '[' << b.x << ',' << b.y << ',' << b.width << ','
+               << b.height << ']';
+        }
+        os << ']';
+        if (result.cargoCount > 0) {
+            os << ",\"cargoT\":" << result.cargoTime << ",\"cargo\":[";
+            for (int i = 0; i < result.cargoCount; ++i) {
+                const Cargo& c = result.cargo[i];
+                if (i != 0) os << ',';
+                os << '[' << c.label << ','
+                   << Fixed(c.confidence, 2) << ',' << c.box.x
+                   << ',' << c.box.y << ',' << c.box.width << ','
+                   << c.box.height << ']';
+            }
+            os << ']';
+        }
+        os << '}';
+    }
+}
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_SEQLOCK
+#define TEXASTORQUE_SEQLOCK
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace texastorque {
+    // Single-writer, many-reader latest-value slot. The writer never
+    // blocks; readers retry if they raced a write.
+    template <typename T>
+    class Seqlock {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Seqlock values are copied with memcpy");
+
+    public:
+        void Store(const T& value) {
+            uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(&data, &value, sizeof(T));
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        T Load() const {
+            T value;
+            uint64_t before, after;
+            do {
+                before = sequence.load(std::memory_order_acquire);
+                std::memcpy(&value, &data, sizeof(T));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) != 0 || before != after);
+            return value;
+        }
+
+        // Even and increasing; changes once per Store().
+        uint64_t Sequence() const {
+            return sequence.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<uint64_t> sequence{0};
+        T data{};
+    };
+}
+
+#endif
@@ -32,11 +32,26 @@
 #include "opencv2/objdetect.hpp"
 #include "opencv2/videoio.hpp"
 
+#include "CargoDetector.hh"
+#include "Pipeline.hh"
+#include "PoseEstimator.hh"
+#include "Realtime.hh"
+#include "ThermalGovernor.hh"
+
 namespace setup {
     static const char *configFile = "/boot/frc.json";
 
     unsigned int team;
     bool server = false;
+    texastorque::RealtimeConfig realtimeConfig;
+    double watchdogTimeout = 2.0;
+    unsigned int metricsPort = 5800;
+    unsigned int feedPort = 5801;
+    std::string traceDirectory = "/tmp";
+    texastorque::PipelineConfig pipelineConfig;
+    texastorque::EstimatorConfig estimatorConfig;
+    texastorque::CargoConfig cargoConfig;
+    texastorque::ThermalConfig thermalConfig;
 
     struct CameraConfig {
         std::string name;
@@ -82,6 +97,8 @@ namespace setup {
     }
 
     bool ReadConfig() {
+        cameraConfigs.clear();
+
         // open config file
         std::error_code ec;
         wpi::raw_fd_istream is(configFile, ec);
@@ -131,6 +148,372 @@ namespace setup {
             }
         }
 
+        // realtime (optional)
+        if (j.count("realtime") != 0) {
+            try {
+                auto& rt = j.at("realtime");
+                if (rt.count("cpu") != 0)
+                    realtimeConfig.cpu = rt.at("cpu").get<int>();
+                if (rt.count("priority") != 0)
+                    realtimeConfig.priority = rt.at("priority").get<int>();
+                if (rt.count("mlockall") != 0)
+                    realtimeConfig.lockMemory = rt.at("mlockall").get<bool>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read realtime: " << e.what() << '\n';
+            }
+        }
+
+        // watchdog (optional)
+        if (j.count("watchdog") != 0) {
+            try {
+                watchdogTimeout = j.at("watchdog").at("timeout").get<double>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read watchdog: " << e.what() << '\n';
+            }
+        }
+
+        // metrics (optional)
+        if (j.count("metrics") != 0) {
+            try {
+                metricsPort = j.at("metrics").at("port").get<unsigned int>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read metrics: " << e.what() << '\n';
+            }
+        }
+
+        // detection feed (optional)
+        if (j.count("feed") != 0) {
+            try {
+                feedPort = j.at("feed").at("port").get<unsigned int>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read feed: " << e.what() << '\n';
+            }
+        }
+
+        // hub (optional)
+        if (j.count("hub") != 0) {
+            try {
+                auto& hub = j.at("hub");
+                auto& hubConfig = pipelineConfig.hub;
+                auto scalar = [](const wpi::json& a) {
+                    return cv::Scalar(a.at(0).get<double>(),
+                                      a.at(1).get<double>(),
+                                      a.at(2).get<double>());
+                };
+                if (hub.count("lower") != 0) hubConfig.lower = scalar(hub.at("lower"));
+                if (hub.count("upper") != 0) hubConfig.upper = scalar(hub.at("upper"));
+                if (hub.count("space") != 0) {
+                    auto space = hub.at("space").get<std::string>();
+                    if (space == "hsv") {
+                        hubConfig.space = texastorque::ColorSpace::kHsv;
+                    } else if (space == "ycrcb") {
+                        hubConfig.space = texastorque::ColorSpace::kYCrCb;
+                    } else {
+                        ParseError() << "could not understand hub space value '"
+                                     << space << "'\n";
+                    }
+                }
+                if (hub.count("lutBits") != 0) {
+                    int bits = hub.at("lutBits").get<int>();
+                    if (texastorque::ValidLutBits(bits))
+                        hubConfig.lutBits = bits;
+                    else
+                        ParseError() << "hub lutBits must be 0, 5 or 6\n";
+                }
+                if (hub.count("packedMask") != 0)
+                    hubConfig.packedMask = hub.at("packedMask").get<bool>();
+                if (hub.count("morphologySize") != 0) {
+                    int size = hub.at("morphologySize").get<int>();
+                    if (size >= 1 && size <= texastorque::kMaxMorphologySize)
+                        hubConfig.morphologySize = size;
+                    else
+                        ParseError() << "hub morphologySize must be 1 to "
+                                     << texastorque::kMaxMorphologySize << '\n';
+                }
+                if (hub.count("minArea") != 0)
+                    hubConfig.minArea = hub.at("minArea").get<double>();
+                if (hub.count("maxArea") != 0)
+                    hubConfig.maxArea = hub.at("maxArea").get<double>();
+                if (hub.count("horizontalFov") != 0)
+                    hubConfig.horizontalFov = hub.at("horizontalFov").get<double>();
+                if (hub.count("verticalFov") != 0)
+                    hubConfig.verticalFov = hub.at("verticalFov").get<double>();
+                if (hub.count("cameraHeight") != 0)
+                    hubConfig.cameraHeight = hub.at("cameraHeight").get<double>();
+                if (hub.count("cameraPitch") != 0)
+                    hubConfig.cameraPitch = hub.at("cameraPitch").get<double>();
+                if (hub.count("hubHeight") != 0)
+                    hubConfig.hubHeight = hub.at("hubHeight").get<double>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read hub: " << e.what() << '\n';
+            }
+        }
+
+        // filter (optional)
+        if (j.count("filter") != 0) {
+            try {
+                auto& filter = j.at("filter");
+                auto& filterConfig = pipelineConfig.filter;
+                auto field = [](const wpi::json& f, texastorque::FilterConfig& c) {
+                    if (f.count("window") != 0) c.window = f.at("window").get<int>();
+                    if (f.count("timeConstant") != 0)
+                        c.timeConstant = f.at("timeConstant").get<double>();
+                    if (f.count("outlierThreshold") != 0)
+                        c.outlierThreshold = f.at("outlierThreshold").get<double>();
+                };
+                if (filter.count("yaw") != 0) field(filter.at("yaw"), filterConfig.yaw);
+                if (filter.count("pitch") != 0) field(filter.at("pitch"), filterConfig.pitch);
+                if (filter.count("distance") != 0)
+                    field(filter.at("distance"), filterConfig.distance);
+                if (filter.count("resetAfter") != 0)
+                    filterConfig.resetAfter = filter.at("resetAfter").get<double>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read filter: " << e.what() << '\n';
+            }
+        }
+
+        // field (optional)
+        if (j.count("field") != 0) {
+            try {
+                auto& field = j.at("field");
+                auto& fieldConfig = pipelineConfig.field;
+                if (field.count("hubX") != 0) fieldConfig.hubX = field.at("hubX").get<double>();
+                if (field.count("hubY") != 0) fieldConfig.hubY = field.at("hubY").get<double>();
+                if (field.count("hubRadius") != 0)
+                    fieldConfig.hubRadius = field.at("hubRadius").get<double>();
+                if (field.count("cameraX") != 0)
+                    fieldConfig.cameraX = field.at("cameraX").get<double>();
+                if (field.count("cameraY") != 0)
+                    fieldConfig.cameraY = field.at("cameraY").get<double>();
+                if (field.count("cameraRotation") != 0)
+                    fieldConfig.cameraRotation = field.at("cameraRotation").get<double>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read field: " << e.what() << '\n';
+            }
+        }
+
+        // tracking (optional)
+        if (j.count("tracking") != 0) {
+            try {
+                auto& tracking = j.at("tracking");
+                auto& trackerConfig = pipelineConfig.tracker;
+                if (tracking.count("detectEvery") != 0)
+                    trackerConfig.detectEvery = tracking.at("detectEvery").get<int>();
+                if (tracking.count("minConfidence") != 0)
+                    trackerConfig.minConfidence = tracking.at("minConfidence").get<double>();
+                if (tracking.count("maxError") != 0)
+                    trackerConfig.maxError = tracking.at("maxError").get<double>();
+                if (tracking.count("minTracked") != 0) {
+                    double share = tracking.at("minTracked").get<double>();
+                    if (share > 0 && share <= 1)
+                        trackerConfig.minTracked = share;
+                    else
+                        ParseError() << "tracking minTracked must be in (0, 1]\n";
+                }
+                if (tracking.count("window") != 0)
+                    trackerConfig.window = tracking.at("window").get<int>();
+                if (tracking.count("levels") != 0)
+                    trackerConfig.levels = tracking.at("levels").get<int>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read tracking: " << e.what() << '\n';
+            }
+        }
+
+        // shooter (optional)
+        if (j.count("shooter") != 0) {
+            try {
+                auto& shooter = j.at("shooter");
+                if (shooter.count("movingIterations") != 0)
+                    pipelineConfig.movingIterations =
+                            shooter.at("movingIterations").get<int>();
+                if (shooter.count("step") != 0) {
+                    double step = shooter.at("step").get<double>();
+                    if (step > 0)
+                        pipelineConfig.shooterStep = step;
+                    else
+                        ParseError() << "shooter step must be positive\n";
+                }
+                pipelineConfig.shooter.clear();
+                for (auto&& row : shooter.at("table"))
+                    pipelineConfig.shooter.push_back({row.at(0).get<double>(),
+                                                      row.at(1).get<double>(),
+                                                      row.at(2).get<double>(),
+                                                      row.size() > 3
+                                                          ? row.at(3).get<double>()
+                                                          : 0.0});
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read shooter: " << e.what() << '\n';
+            }
+        }
+
+        // estimator (optional)
+        if (j.count("estimator") != 0) {
+            try {
+                auto& est = j.at("estimator");
+                auto triple = [](const wpi::json& a) {
+                    return std::array<double, 3>{a.at(0).get<double>(),
+                                                 a.at(1).get<double>(),
+                                                 a.at(2).get<double>()};
+                };
+                if (est.count("rate") != 0)
+                    estimatorConfig.rate = est.at("rate").get<double>();
+                if (est.count("odometryStdDevs") != 0)
+                    estimatorConfig.odometryStdDevs = triple(est.at("odometryStdDevs"));
+                if (est.count("visionStdDevs") != 0)
+                    estimatorConfig.visionStdDevs = triple(est.at("visionStdDevs"));
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read estimator: " << e.what() << '\n';
+            }
+        }
+
+        // shared memory export (optional)
+        if (j.count("shm") != 0) {
+            try {
+                auto& shm = j.at("shm");
+                pipelineConfig.shmSlots = 4;
+                if (shm.count("name") != 0)
+                    pipelineConfig.shmName = shm.at("name").get<std::string>();
+                if (shm.count("slots") != 0)
+                    pipelineConfig.shmSlots = shm.at("slots").get<uint32_t>();
+                if (shm.count("slotBytes") != 0)
+                    pipelineConfig.shmSlotBytes = shm.at("slotBytes").get<uint32_t>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read shm: " << e.what() << '\n';
+            }
+        }
+
+        // lens calibration (optional)
+        if (j.count("calibration") != 0) {
+            try {
+                auto& cal = j.at("calibration");
+                auto& calibration = pipelineConfig.calibration;
+                calibration.size = cv::Size(cal.at("width").get<int>(),
+                                            cal.at("height").get<int>());
+                auto& m = cal.at("matrix");
+                calibration.fx = m.at(0).get<double>();
+                calibration.cx = m.at(2).get<double>();
+                calibration.fy = m.at(4).get<double>();
+                calibration.cy = m.at(5).get<double>();
+                if (cal.count("distortion") != 0)
+                    calibration.distortion =
+                            cal.at("distortion").get<std::vector<double>>();
+                if (cal.count("step") != 0)
+                    calibration.step = cal.at("step").get<int>();
+                if (cal.count("cache") != 0)
+                    pipelineConfig.rayCache = cal.at("cache").get<std::string>();
+                // OpenCV throws on any other count, so fall back to the
+                // field-of-view model instead.
+                if (!texastorque::CameraCalibration::ValidDistortionCount(
+                            calibration.distortion.size())) {
+                    ParseError() << "calibration distortion needs 4, 5, 8, 12 "
+                                 << "or 14 coefficients, ignoring calibration\n";
+                    calibration = texastorque::CameraCalibration{};
+                }
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read calibration: " << e.what() << '\n';
+            }
+        }
+
+        // debug stream (optional)
+        if (j.count("stream") != 0) {
+            try {
+                auto& stream = j.at("stream");
+                auto& streamConfig = pipelineConfig.stream;
+                if (stream.count("scale") != 0)
+                    streamConfig.scale = stream.at("scale").get<int>();
+                if (stream.count("undistort") != 0)
+                    streamConfig.undistort = stream.at("undistort").get<bool>();
+                if (stream.count("overlay") != 0)
+                    streamConfig.overlay = stream.at("overlay").get<bool>();
+                if (stream.count("cpu") != 0)
+                    streamConfig.realtime.cpu = stream.at("cpu").get<int>();
+                if (stream.count("nice") != 0)
+                    streamConfig.realtime.nice = stream.at("nice").get<int>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read stream: " << e.what() << '\n';
+            }
+        }
+
+        // profile (optional)
+        if (j.count("profile") != 0) {
+            try {
+                auto& profile = j.at("profile");
+                if (profile.count("perf") != 0)
+                    pipelineConfig.perfCounters = profile.at("perf").get<bool>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read profile: " << e.what() << '\n';
+            }
+        }
+
+        // thermal governor (optional)
+        if (j.count("thermal") != 0) {
+            try {
+                auto& thermal = j.at("thermal");
+                if (thermal.count("enabled") != 0)
+                    thermalConfig.enabled = thermal.at("enabled").get<bool>();
+                if (thermal.count("start") != 0)
+                    thermalConfig.startTemperature = thermal.at("start").get<double>();
+                if (thermal.count("step") != 0)
+                    thermalConfig.step = thermal.at("step").get<double>();
+                if (thermal.count("hysteresis") != 0)
+                    thermalConfig.hysteresis = thermal.at("hysteresis").get<double>();
+                if (thermal.count("throttleRatio") != 0)
+                    thermalConfig.throttleRatio =
+                            thermal.at("throttleRatio").get<double>();
+                if (thermal.count("hold") != 0)
+                    thermalConfig.hold = thermal.at("hold").get<double>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read thermal: " << e.what() << '\n';
+            }
+        }
+
+        // trace (optional)
+        if (j.count("trace") != 0) {
+            try {
+                traceDirectory = j.at("trace").at("directory").get<std::string>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read trace: " << e.what() << '\n';
+            }
+        }
+
+        // cargo detector (optional)
+        if (j.count("cargo") != 0) {
+            try {
+                auto& cargo = j.at("cargo");
+                cargoConfig.model = cargo.at("model").get<std::string>();
+                if (cargo.count("config") != 0)
+                    cargoConfig.config = cargo.at("config").get<std::string>();
+                if (cargo.count("width") != 0)
+                    cargoConfig.inputWidth = cargo.at("width").get<int>();
+                if (cargo.count("height") != 0)
+                    cargoConfig.inputHeight = cargo.at("height").get<int>();
+                if (cargo.count("scale") != 0)
+                    cargoConfig.scale = cargo.at("scale").get<double>();
+                if (cargo.count("mean") != 0) {
+                    auto& mean = cargo.at("mean");
+                    cargoConfig.mean = cv::Scalar(mean.at(0).get<double>(),
+                                                  mean.at(1).get<double>(),
+                                                  mean.at(2).get<double>());
+                }
+                if (cargo.count("swapRB") != 0)
+                    cargoConfig.swapRB = cargo.at("swapRB").get<bool>();
+                if (cargo.count("minConfidence") != 0)
+                    cargoConfig.minConfidence = cargo.at("minConfidence").get<double>();
+                if (cargo.count("nms") != 0)
+                    cargoConfig.nmsThreshold = cargo.at("nms").get<double>();
+                if (cargo.count("rate") != 0)
+                    cargoConfig.rate = cargo.at("rate").get<double>();
+                if (cargo.count("maxAge") != 0)
+                    cargoConfig.maxAge = cargo.at("maxAge").get<double>();
+                if (cargo.count("cpu") != 0)
+                    cargoConfig.realtime.cpu = cargo.at("cpu").get<int>();
+                if (cargo.count("priority") != 0)
+                    cargoConfig.realtime.priority = cargo.at("priority").get<int>();
+            } catch (const wpi::json::exception &e) {
+                ParseError() << "could not read cargo: " << e.what() << '\n';
+            }
+        }
+
         // cameras
         try {
             for (auto &&camera: j.at("cameras")) {
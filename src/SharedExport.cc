@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "SharedExport.hh"
+
+#include <cerrno>
+#include <new>
+
+#include "wpi/raw_ostream.h"
+
+namespace texastorque {
+    SharedExport::~SharedExport() {
+        Close();
+    }
+
+    bool SharedExport::Open(const std::string& name, uint32_t slotCount,
+                            uint32_t slotBytes) {
+        Close();
+        if (slotCount == 0) return false;
+        size_t bytes = SharedSize(slotCount, slotBytes);
+
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) {
+            wpi::errs() << "could not open shared memory '" << name
+                        << "': " << std::strerror(errno) << '\n';
+            return false;
+        }
+        if (ftruncate(fd, bytes) != 0) {
+            wpi::errs() << "could not size shared memory '" << name
+                        << "': " << std::strerror(errno) << '\n';
+            close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) {
+            wpi::errs() << "could not map shared memory '" << name
+                        << "': " << std::strerror(errno) << '\n';
+            return false;
+        }
+
+        this->name = name;
+        base = p;
+        size = bytes;
+        std::memset(base, 0, size);
+        header = new (base) SharedHeader();
+        header->slotCount = slotCount;
+        header->slotBytes = slotBytes;
+        for (uint32_t i = 0; i < slotCount; ++i)
+            new (SlotAt(base, slotBytes, i)) SharedSlotHeader();
+        std::atomic_thread_fence(std::memory_order_release);
+        header->version = kSharedVersion;
+        header->magic = kSharedMagic;
+
+        wpi::outs() << "Exporting frames to shared memory '" << name << "' ("
+                    << slotCount << " x " << slotBytes << " bytes)\n";
+        return true;
+    }
+
+    void SharedExport::Close() {
+        if (base == nullptr) return;
+        header->magic = 0;
+        munmap(base, size);
+        shm_unlink(name.c_str());
+        base = nullptr;
+        header = nullptr;
+        size = 0;
+    }
+
+    void SharedExport::PutFrame(const cv::Mat& frame, uint64_t frameTime) {
+        if (header == nullptr) return;
+        size_t bytes = frame.total() * frame.elemSize();
+        if (bytes > header->slotBytes) return;
+
+        uint64_t number = ++frameNumber;
+        auto slot = SlotAt(base, header->slotBytes, number % header->slotCount);
+        uint64_t seq = slot->sequence.load(std::memory_order_relaxed);
+        slot->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot->frameNumber = number;
+        slot->frameTime = frameTime;
+        slot->width = frame.cols;
+        slot->height = frame.rows;
+        slot->type = frame.type();
+        slot->step = static_cast<int32_t>(frame.cols * frame.elemSize());
+        auto dst = reinterpret_cast<uint8_t*>(slot + 1);
+        if (frame.isContinuous()) {
+            std::memcpy(dst, frame.data, bytes);
+        } else {
+            for (int r = 0; r < frame.rows; ++r)
+                std::memcpy(dst + r * slot->step, frame.ptr(r), slot->step);
+        }
+
+        slot->sequence.store(seq + 2, std::memory_order_release);
+        header->latestFrame.store(number, std::memory_order_release);
+    }
+
+    void SharedExport::PutResult(const Result& result) {
+        if (header == nullptr) return;
+        uint64_t seq = header->resultSequence.load(std::memory_order_relaxed);
+        header->resultSequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&header->result, &result, sizeof(Result));
+        header->resultSequence.store(seq + 2, std::memory_order_release);
+    }
+}
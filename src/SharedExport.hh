@@ -0,0 +1,49 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_SHAREDEXPORT
+#define TEXASTORQUE_SHAREDEXPORT
+
+#include <cstdint>
+#include <string>
+
+#include "opencv2/core.hpp"
+
+#include "Result.hh"
+#include "SharedMemory.hh"
+
+namespace texastorque {
+    // Writer side of SharedMemory.hh, owned by the vision thread. Never
+    // waits on readers; a slow reader just sees its frame invalidated.
+    class SharedExport {
+    public:
+        SharedExport() = default;
+        SharedExport(const SharedExport&) = delete;
+        SharedExport& operator=(const SharedExport&) = delete;
+        ~SharedExport();
+
+        bool Open(const std::string& name, uint32_t slotCount,
+                  uint32_t slotBytes);
+        void Close();
+
+        bool IsOpen() const {
+            return header != nullptr;
+        }
+
+        // Frames larger than the slot size are skipped.
+        void PutFrame(const cv::Mat& frame, uint64_t frameTime);
+        void PutResult(const Result& result);
+
+    private:
+        std::string name;
+        void* base = nullptr;
+        size_t size = 0;
+        SharedHeader* header = nullptr;
+        uint64_t frameNumber = 0;
+    };
+}
+
+#endif
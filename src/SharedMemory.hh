@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+// Shared-memory layout for exporting frames and results to other
+// processes on the Pi, plus a header-only reader. Readers map the region
+// read-only and never block the vision process; a reader that crashes
+// cannot corrupt it, and a writer that crashes mid-write makes reads
+// fail rather than hang.
+//
+// Usage from a sibling process:
+//
+//     texastorque::SharedReader reader;
+//     if (!reader.Open("/texastorque-Front")) ...
+//     texastorque::Result result;
+//     if (reader.ReadResult(result)) ...
+//     texastorque::SharedFrame frame;
+//     if (reader.LatestFrame(frame)) {
+//         cv::Mat view(frame.height, frame.width, frame.type,
+//                      (void*)frame.data, frame.step);
+//         ... use view ...
+//         if (!reader.StillValid(frame)) ... overwritten, discard ...
+//     }
+
+#ifndef TEXASTORQUE_SHAREDMEMORY
+#define TEXASTORQUE_SHAREDMEMORY
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Result.hh"
+
+namespace texastorque {
+    constexpr uint32_t kSharedMagic = 0x54545631;  // "TTV1"
+    constexpr uint32_t kSharedVersion = 7;
+
+    // Each slot (and the result) is a seqlock: odd while being written.
+    struct SharedSlotHeader {
+        std::atomic<uint64_t> sequence;
+        uint64_t frameNumber;
+        uint64_t frameTime;
+        int32_t width, height, type, step;
+    };
+
+    struct SharedHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t slotCount;
+        uint32_t slotBytes;  // pixel bytes per slot, after the slot header
+        std::atomic<uint64_t> latestFrame;  // frameNumber of newest slot
+        std::atomic<uint64_t> resultSequence;
+        Result result;
+    };
+
+    inline size_t SlotStride(uint32_t slotBytes) {
+        return (sizeof(SharedSlotHeader) + slotBytes + 63) & ~size_t(63);
+    }
+
+    inline size_t SharedSize(uint32_t slotCount, uint32_t slotBytes) {
+        return ((sizeof(SharedHeader) + 63) & ~size_t(63)) +
+               slotCount * SlotStride(slotBytes);
+    }
+
+    inline SharedSlotHeader* SlotAt(void* base, uint32_t slotBytes,
+                                    uint32_t index) {
+        auto p = static_cast<char*>(base) +
+                 ((sizeof(SharedHeader) + 63) & ~size_t(63)) +
+                 index * SlotStride(slotBytes);
+        return reinterpret_cast<SharedSlotHeader*>(p);
+    }
+
+    // A frame still living in shared memory. data is only meaningful
+    // while StillValid() says so.
+    struct SharedFrame {
+        const uint8_t* data;
+        uint64_t frameNumber;
+        uint64_t frameTime;
+        int width, height, type, step;
+
+        const SharedSlotHeader* slot;
+        uint64_t sequence;
+    };
+
+    class SharedReader {
+    public:
+        SharedReader() = default;
+        SharedReader(const SharedReader&) = delete;
+        SharedReader& operator=(const SharedReader&) = delete;
+
+        ~SharedReader() {
+            Close();
+        }
+
+        bool Open(const std::string& name) {
+            Close();
+            int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0 ||
+                static_cast<size_t>(st.st_size) < sizeof(SharedHeader)) {
+                close(fd);
+                return false;
+            }
+            void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) return false;
+            base = p;
+            size = st.st_size;
+            header = static_cast<const SharedHeader*>(base);
+            if (header->magic != kSharedMagic ||
+                header->version != kSharedVersion ||
+                size < SharedSize(header->slotCount, header->slotBytes)) {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        void Close() {
+            if (base != nullptr) munmap(base, size);
+            base = nullptr;
+            header = nullptr;
+            size = 0;
+        }
+
+        bool IsOpen() const {
+            return header != nullptr;
+        }
+
+        // The writer clears the magic when it shuts down or restarts;
+        // reopen to pick up the new region.
+        bool Stale() const {
+            return IsOpen() && header->magic != kSharedMagic;
+        }
+
+        // Copies the latest result; false if nothing has been written yet,
+        // or if the write stayed in progress for kReadAttempts tries (the
+        // writer died mid-write or is stuck).
+        bool ReadResult(Result& out) const {
+            if (!IsOpen()) return false;
+            for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+                uint64_t before =
+                        header->resultSequence.load(std::memory_order_acquire);
+                std::memcpy(&out, &header->result, sizeof(Result));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                uint64_t after =
+                        header->resultSequence.load(std::memory_order_relaxed);
+                if ((before & 1) == 0 && before == after) return before != 0;
+            }
+            return false;
+        }
+
+        // Points frame at the newest complete slot without copying.
+        bool LatestFrame(SharedFrame& frame) const {
+            if (!IsOpen()) return false;
+            uint64_t number = header->latestFrame.load(std::memory_order_acquire);
+            if (number == 0) return false;
+            auto slot = SlotAt(base, header->slotBytes,
+                               number % header->slotCount);
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            if ((seq & 1) != 0) return false;
+            frame.data = reinterpret_cast<const uint8_t*>(slot + 1);
+            frame.frameNumber = slot->frameNumber;
+            frame.frameTime = slot->frameTime;
+            frame.width = slot->width;
+            frame.height = slot->height;
+            frame.type = slot->type;
+            frame.step = slot->step;
+            frame.slot = slot;
+            frame.sequence = seq;
+            return StillValid(frame) && frame.frameNumber == number;
+        }
+
+        // True if the writer has not started overwriting the frame's slot.
+        bool StillValid(const SharedFrame& frame) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return frame.slot->sequence.load(std::memory_order_relaxed) ==
+                   frame.sequence;
+        }
+
+    private:
+        // A result write is a sub-microsecond memcpy, so this many retries
+        // only run out if it never finishes.
+        static constexpr int kReadAttempts = 1000;
+
+        void* base = nullptr;
+        size_t size = 0;
+        const SharedHeader* header = nullptr;
+    };
+}
+
+#endif
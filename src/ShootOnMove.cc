@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "ShootOnMove.hh"
+
+#include <cmath>
+
+namespace texastorque {
+    static constexpr double kRadians = M_PI / 180.0;
+
+    MovingShot SolveMovingShot(const ShooterLut& lut, double yaw,
+                               double distance, double hubRadius, double vx,
+                               double vy, double cameraRotation,
+                               int maxIterations, double tolerance) {
+        MovingShot shot;
+
+        // Hub centre and robot velocity, both in the camera frame
+        // (x forward, y left).
+        double bearing = -yaw * kRadians;
+        double range = distance + hubRadius;
+        double hx = range * std::cos(bearing), hy = range * std::sin(bearing);
+        double c = std::cos(-cameraRotation * kRadians);
+        double s = std::sin(-cameraRotation * kRadians);
+        double cvx = c * vx - s * vy, cvy = s * vx + c * vy;
+
+        double tof;
+        if (!lut.LookupTof(distance, tof)) return shot;
+
+        double x = hx, y = hy;
+        for (shot.iterations = 1; shot.iterations <= maxIterations;
+             ++shot.iterations) {
+            x = hx - cvx * tof;
+            y = hy - cvy * tof;
+            double next;
+            lut.LookupTof(std::hypot(x, y) - hubRadius, next);
+            bool converged = std::abs(next - tof) < tolerance;
+            tof = next;
+            if (converged) break;
+        }
+        if (shot.iterations > maxIterations) shot.iterations = maxIterations;
+
+        shot.valid = true;
+        shot.tof = tof;
+        shot.yaw = -std::atan2(y, x) / kRadians;
+        shot.distance = std::hypot(x, y) - hubRadius;
+        return shot;
+    }
+}
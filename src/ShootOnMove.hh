@@ -0,0 +1,36 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_SHOOTONMOVE
+#define TEXASTORQUE_SHOOTONMOVE
+
+#include "ShooterTable.hh"
+
+namespace texastorque {
+    struct MovingShot {
+        bool valid = false;
+        double yaw = 0;       // degrees, positive right, camera frame
+        double distance = 0;  // m, same reference as the shooter table
+        double tof = 0;       // s
+        int iterations = 0;
+    };
+
+    // Where to aim so a ball that inherits the robot's velocity lands in
+    // the hub: the virtual hub sits at hub - v * tof(|virtual hub|),
+    // solved by fixed-point iteration capped at maxIterations.
+    //
+    // yaw/distance are the observed hub (distance to the tape ring, as
+    // the table uses), hubRadius converts to and from the hub centre,
+    // vx/vy are robot-relative (forward/left, m/s) and cameraRotation is
+    // the camera's yaw on the robot in degrees, CCW positive.
+    MovingShot SolveMovingShot(const ShooterLut& lut, double yaw,
+                               double distance, double hubRadius, double vx,
+                               double vy, double cameraRotation,
+                               int maxIterations = 6,
+                               double tolerance = 1e-3);
+}
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "ShooterTable.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace texastorque {
+    // Fritsch-Carlson tangents for a monotone piecewise cubic Hermite.
+    static std::vector<double> MonotoneTangents(const std::vector<double>& x,
+                                                const std::vector<double>& y) {
+        size_t n = x.size();
+        std::vector<double> secant(n - 1), m(n);
+        for (size_t k = 0; k + 1 < n; ++k)
+            secant[k] = (y[k + 1] - y[k]) / (x[k + 1] - x[k]);
+
+        m[0] = secant[0];
+        m[n - 1] = secant[n - 2];
+        for (size_t k = 1; k + 1 < n; ++k)
+            m[k] = secant[k - 1] * secant[k] <= 0
+                    ? 0 : (secant[k - 1] + secant[k]) / 2;
+
+        for (size_t k = 0; k + 1 < n; ++k) {
+            if (secant[k] == 0) {
+                m[k] = m[k + 1] = 0;
+                continue;
+            }
+            double a = m[k] / secant[k], b = m[k + 1] / secant[k];
+            double h = a * a + b * b;
+            if (h > 9) {
+                double t = 3 / std::sqrt(h);
+                m[k] = t * a * secant[k];
+                m[k + 1] = t * b * secant[k];
+            }
+        }
+        return m;
+    }
+
+    static double Hermite(double x0, double x1, double y0, double y1,
+                          double m0, double m1, double x) {
+        double h = x1 - x0;
+        double t = (x - x0) / h;
+        double t2 = t * t, t3 = t2 * t;
+        return (2 * t3 - 3 * t2 + 1) * y0 + (t3 - 2 * t2 + t) * h * m0 +
+               (-2 * t3 + 3 * t2) * y1 + (t3 - t2) * h * m1;
+    }
+
+    // Upper bound on dense samples; a finer step is widened to fit.
+    static constexpr double kMaxSamples = 1 << 16;
+
+    ShooterLut::ShooterLut(std::vector<ShooterPoint> points, double step)
+            : step(step) {
+        if (!(step > 0)) return;
+        std::sort(points.begin(), points.end(),
+                  [](const ShooterPoint& a, const ShooterPoint& b) {
+                      return a.distance < b.distance;
+                  });
+        points.erase(std::unique(points.begin(), points.end(),
+                                 [](const ShooterPoint& a,
+                                    const ShooterPoint& b) {
+                                     return a.distance == b.distance;
+                                 }),
+                     points.end());
+        if (points.empty()) return;
+        minDistance = points.front().distance;
+        hasTof = std::all_of(points.begin(), points.end(),
+                             [](const ShooterPoint& p) { return p.tof > 0; });
+        if (points.size() == 1) {
+            rpm.push_back(points[0].rpm);
+            hood.push_back(points[0].hood);
+            tof.push_back(points[0].tof);
+            return;
+        }
+
+        std::vector<double> x, yRpm, yHood, yTof;
+        for (auto& p : points) {
+            x.push_back(p.distance);
+            yRpm.push_back(p.rpm);
+            yHood.push_back(p.hood);
+            yTof.push_back(p.tof);
+        }
+        auto mRpm = MonotoneTangents(x, yRpm);
+        auto mHood = MonotoneTangents(x, yHood);
+        auto mTof = MonotoneTangents(x, yTof);
+
+        double span = x.back() - x.front();
+        if (span / this->step > kMaxSamples) this->step = span / kMaxSamples;
+        size_t samples = static_cast<size_t>(span / this->step) + 2;
+        rpm.resize(samples);
+        hood.resize(samples);
+        tof.resize(samples);
+        size_t k = 0;
+        for (size_t i = 0; i < samples; ++i) {
+            double d = std::min(x.front() + i * this->step, x.back());
+            while (k + 2 < x.size() && d > x[k + 1]) ++k;
+            rpm[i] = Hermite(x[k], x[k + 1], yRpm[k], yRpm[k + 1], mRpm[k],
+                             mRpm[k + 1], d);
+            hood[i] = Hermite(x[k], x[k + 1], yHood[k], yHood[k + 1],
+                              mHood[k], mHood[k + 1], d);
+            tof[i] = Hermite(x[k], x[k + 1], yTof[k], yTof[k + 1], mTof[k],
+                             mTof[k + 1], d);
+        }
+    }
+
+    // Fractional index into the dense samples, clamped to the table.
+    double ShooterLut::Position(double distance, size_t& index) const {
+        double pos = (distance - minDistance) / step;
+        pos = std::max(0.0, std::min(pos, double(rpm.size() - 1)));
+        index = static_cast<size_t>(pos);
+        if (index + 1 >= rpm.size()) {
+            index = rpm.size() - 1;
+            return 0;
+        }
+        return pos - index;
+    }
+
+    bool ShooterLut::Lookup(double distance, double& rpmOut,
+                            double& hoodOut) const {
+        if (rpm.empty()) return false;
+        size_t i;
+        double t = Position(distance, i);
+        if (t == 0) {
+            rpmOut = rpm[i];
+            hoodOut = hood[i];
+            return true;
+        }
+        rpmOut = rpm[i] + t * (rpm[i + 1] - rpm[i]);
+        hoodOut = hood[i] + t * (hood[i + 1] - hood[i]);
+        return true;
+    }
+
+    bool ShooterLut::LookupTof(double distance, double& tofOut) const {
+        if (!hasTof) return false;
+        size_t i;
+        double t = Position(distance, i);
+        tofOut = t == 0 ? tof[i] : tof[i] + t * (tof[i + 1] - tof[i]);
+        return true;
+    }
+
+    ShooterTable::ShooterTable(double step) : step(step) {}
+
+    void ShooterTable::Set(std::vector<ShooterPoint> points) {
+        luts.Back() = ShooterLut(std::move(points), step);
+        luts.Publish();
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_SHOOTERTABLE
+#define TEXASTORQUE_SHOOTERTABLE
+
+#include <cstddef>
+#include <vector>
+
+#include "TripleBuffer.hh"
+
+namespace texastorque {
+    // One tuned shot: hub distance (m) to flywheel RPM, hood angle and
+    // ball time of flight (s, 0 if not measured).
+    struct ShooterPoint {
+        double distance, rpm, hood, tof;
+    };
+
+    // Monotone cubic (Fritsch-Carlson) interpolation of the tuned points,
+    // sampled every step metres. Lookups are two loads and a lerp. A step
+    // that is not positive, or a default-constructed LUT, is empty.
+    class ShooterLut {
+    public:
+        ShooterLut() = default;
+        ShooterLut(std::vector<ShooterPoint> points, double step);
+
+        // Clamps to the tuned range; false if the table is empty.
+        bool Lookup(double distance, double& rpm, double& hood) const;
+        bool LookupTof(double distance, double& tof) const;
+
+        bool HasTof() const {
+            return hasTof;
+        }
+
+        size_t Size() const {
+            return rpm.size();
+        }
+
+    private:
+        double minDistance = 0;
+        double step = 0;
+        bool hasTof = false;
+        std::vector<double> rpm;
+        std::vector<double> hood;
+        std::vector<double> tof;
+
+        double Position(double distance, size_t& index) const;
+    };
+
+    // Publishes rebuilt LUTs to the vision thread through a TripleBuffer,
+    // so neither side takes a lock. The writer builds into the back slot;
+    // the reader's table is never touched until it takes a newer one.
+    class ShooterTable {
+    public:
+        explicit ShooterTable(double step = 0.01);
+
+        ShooterTable(const ShooterTable&) = delete;
+        ShooterTable& operator=(const ShooterTable&) = delete;
+
+        // Builds and publishes a new LUT. Single writer at a time.
+        void Set(std::vector<ShooterPoint> points);
+
+        // The newest LUT, empty until the first Set(). Single reader; the
+        // reference is valid until its next call.
+        const ShooterLut& Current() {
+            luts.Update();
+            return luts.Front();
+        }
+
+    private:
+        double step;
+        TripleBuffer<ShooterLut> luts;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "StreamTelemetry.hh"
+
+#include <algorithm>
+
+#include "cscore_cpp.h"
+
+namespace texastorque {
+    static constexpr double kDropThreshold = 0.1;
+
+    StreamTelemetry::StreamTelemetry(std::shared_ptr<nt::NetworkTable> table) {
+        cameraFpsEntry = table->GetEntry("cameraFps");
+        cameraMbpsEntry = table->GetEntry("cameraMbps");
+        processedFpsEntry = table->GetEntry("processedFps");
+        streamFpsEntry = table->GetEntry("streamFps");
+        streamRawMbpsEntry = table->GetEntry("streamRawMbps");
+        usbDropEntry = table->GetEntry("usbDropRatio");
+        processingDropEntry = table->GetEntry("processingDropRatio");
+        streamDropEntry = table->GetEntry("streamDropRatio");
+        bottleneckEntry = table->GetEntry("bottleneck");
+    }
+
+    static double DropRatio(double out, double in) {
+        return in <= 0 ? 0 : std::clamp(1.0 - out / in, 0.0, 1.0);
+    }
+
+    StreamStats StreamTelemetry::Update(const cs::VideoSource& camera,
+                                        const cs::VideoSource& stream,
+                                        uint64_t processed,
+                                        uint64_t streamed) {
+        CS_Status status = 0;
+        double elapsed = cs::GetTelemetryElapsedTime();
+        auto value = [&](const cs::VideoSource& source, CS_TelemetryKind kind) {
+            status = 0;
+            int64_t v = cs::GetTelemetryValue(source.GetHandle(), kind, &status);
+            return status == 0 ? static_cast<double>(v) : 0.0;
+        };
+
+        // A rebuilt pipeline restarts its count; skip that period.
+        bool valid = !first && processed >= lastProcessed &&
+                     streamed >= lastStreamed && elapsed > 0;
+        uint64_t frames = valid ? processed - lastProcessed : 0;
+        uint64_t sent = valid ? streamed - lastStreamed : 0;
+        lastProcessed = processed;
+        lastStreamed = streamed;
+        first = false;
+
+        StreamStats stats{};
+        if (!valid) return stats;
+        stats.expectedFps = camera.GetVideoMode().fps;
+        stats.cameraFps = value(camera, CS_SOURCE_FRAMES_RECEIVED) / elapsed;
+        stats.cameraMbps =
+                value(camera, CS_SOURCE_BYTES_RECEIVED) * 8 / elapsed / 1e6;
+        stats.processedFps = frames / elapsed;
+        stats.streamedFps = sent / elapsed;
+        stats.streamFps = value(stream, CS_SOURCE_FRAMES_RECEIVED) / elapsed;
+        stats.streamRawMbps =
+                value(stream, CS_SOURCE_BYTES_RECEIVED) * 8 / elapsed / 1e6;
+        stats.usbDrop = DropRatio(stats.cameraFps, stats.expectedFps);
+        stats.processingDrop = DropRatio(stats.processedFps, stats.cameraFps);
+        stats.streamDrop = DropRatio(stats.streamFps, stats.streamedFps);
+
+        cameraFpsEntry.SetDouble(stats.cameraFps);
+        cameraMbpsEntry.SetDouble(stats.cameraMbps);
+        processedFpsEntry.SetDouble(stats.processedFps);
+        streamFpsEntry.SetDouble(stats.streamFps);
+        streamRawMbpsEntry.SetDouble(stats.streamRawMbps);
+        usbDropEntry.SetDouble(stats.usbDrop);
+        processingDropEntry.SetDouble(stats.processingDrop);
+        streamDropEntry.SetDouble(stats.streamDrop);
+        bottleneckEntry.SetString(Bottleneck(stats));
+        return stats;
+    }
+
+    const char* Bottleneck(const StreamStats& stats) {
+        if (stats.usbDrop > kDropThreshold) return "usb";
+        if (stats.processingDrop > kDropThreshold) return "processing";
+        if (stats.streamDrop > kDropThreshold) return "stream";
+        return "none";
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_STREAMTELEMETRY
+#define TEXASTORQUE_STREAMTELEMETRY
+
+#include <cstdint>
+#include <memory>
+
+#include "cscore_oo.h"
+#include "networktables/NetworkTable.h"
+#include "networktables/NetworkTableEntry.h"
+
+namespace texastorque {
+    // Rates and drop ratios for one camera over a cscore telemetry period.
+    struct StreamStats {
+        double expectedFps;   // camera video mode
+        double cameraFps;     // frames the camera delivered
+        double cameraMbps;    // compressed bytes over USB
+        double processedFps;  // frames the pipeline finished
+        double streamedFps;   // frames the pipeline sent to the stream
+        double streamFps;     // frames the debug stream received
+        double streamRawMbps; // uncompressed BGR handed to the stream
+
+        double usbDrop;        // 1 - camera / expected
+        double processingDrop; // 1 - processed / camera
+        double streamDrop;     // 1 - stream / streamed
+    };
+
+    // Compares cscore's per-period counters for the camera and the debug
+    // stream's CvSource against the pipeline's own frame count, and
+    // publishes which stage is losing frames. Update() once per telemetry
+    // period (the kTelemetryUpdated event), from one thread.
+    class StreamTelemetry {
+    public:
+        explicit StreamTelemetry(std::shared_ptr<nt::NetworkTable> table);
+
+        // processed and streamed are the pipeline's running frame counts;
+        // they may restart from zero when the pipeline is rebuilt. Frames
+        // the pipeline chose not to stream are not counted as drops.
+        StreamStats Update(const cs::VideoSource& camera,
+                           const cs::VideoSource& stream, uint64_t processed,
+                           uint64_t streamed);
+
+    private:
+        uint64_t lastProcessed = 0;
+        uint64_t lastStreamed = 0;
+        bool first = true;
+
+        nt::NetworkTableEntry cameraFpsEntry;
+        nt::NetworkTableEntry cameraMbpsEntry;
+        nt::NetworkTableEntry processedFpsEntry;
+        nt::NetworkTableEntry streamFpsEntry;
+        nt::NetworkTableEntry streamRawMbpsEntry;
+        nt::NetworkTableEntry usbDropEntry;
+        nt::NetworkTableEntry processingDropEntry;
+        nt::NetworkTableEntry streamDropEntry;
+        nt::NetworkTableEntry bottleneckEntry;
+    };
+
+    // "usb", "processing", "stream" or "none": the first stage losing
+    // more than a tenth of its input.
+    const char* Bottleneck(const StreamStats& stats);
+}
+
+#endif
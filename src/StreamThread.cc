@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "StreamThread.hh"
+
+#include <algorithm>
+#include <chrono>
+
+#include "opencv2/imgproc.hpp"
+
+#include "Metrics.hh"
+
+namespace texastorque {
+    StreamThread::StreamThread(cs::CvSource source, const StreamConfig& config,
+                               const CameraCalibration& calibration)
+            : source(source), config(config), calibration(calibration) {}
+
+    StreamThread::~StreamThread() {
+        Stop();
+    }
+
+    // Publish() notifies without the mutex so the vision thread never
+    // blocks on it; a wakeup that lands just before the stream thread
+    // sleeps is caught by this timeout instead.
+    static constexpr std::chrono::milliseconds kWake(10);
+
+    void StreamThread::Start() {
+        if (thread.joinable()) return;
+        running = true;
+        thread = std::thread([this] { Run(); });
+    }
+
+    void StreamThread::Stop() {
+        if (!thread.joinable()) return;
+        running = false;
+        cv.notify_all();
+        thread.join();
+    }
+
+    bool StreamThread::Publish(const Result& result) {
+        buffer.Back().result = result;
+        bool taken = buffer.Publish();
+        cv.notify_one();
+        return taken;
+    }
+
+    void StreamThread::Run() {
+        ApplyRealtime(config.realtime, "stream");
+
+        while (running) {
+            if (!buffer.Update()) {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, kWake);
+                continue;
+            }
+            Slot& slot = buffer.Front();
+
+            // Shrink first so drawing and the remap touch fewer pixels.
+            int64_t start = MicrosNow();
+            int scale = std::max(1, config.scale) *
+                        std::max(1, extraScale.load(std::memory_order_relaxed));
+            cv::Mat* out = &slot.frame;
+            if (scale > 1) {
+                cv::resize(slot.frame, scaled, cv::Size(), 1.0 / scale,
+                           1.0 / scale, cv::INTER_AREA);
+                out = &scaled;
+            }
+            // Overlays are in distorted pixels, so they go on before the
+            // remap and move with the image.
+            if (config.overlay) Draw(*out, slot.result, scale);
+            if (config.undistort && calibration.Valid()) {
+                if (out->size() != mapSize) BuildMaps(out->size());
+                cv::remap(*out, undistorted, map1, map2, cv::INTER_LINEAR);
+                out = &undistorted;
+            }
+            source.PutFrame(*out);
+            int64_t end = MicrosNow();
+            latency.Record(end - start);
+            TraceComplete("stream", start, end);
+        }
+    }
+
+    // The calibration's intrinsics scaled to this size, used as both the
+    // source and the new camera matrix so the view keeps its focal length.
+    void StreamThread::BuildMaps(const cv::Size& size) {
+        double sx = double(size.width) / calibration.size.width;
+        double sy = double(size.height) / calibration.size.height;
+        cv::Matx33d matrix(calibration.fx * sx, 0,
+                           (calibration.cx + 0.5) * sx - 0.5, 0,
+                           calibration.fy * sy,
+                           (calibration.cy + 0.5) * sy - 0.5, 0, 0, 1);
+        cv::Mat x, y;
+        cv::initUndistortRectifyMap(matrix, calibration.distortion, cv::noArray(),
+                                    matrix, size, CV_32FC1, x, y);
+        cv::convertMaps(x, y, map1, map2, CV_16SC2);
+        mapSize = size;
+    }
+
+    void StreamThread::Draw(cv::Mat& image, const Result& result,
+                            int scale) const {
+        auto rect = [scale](const Box& b) {
+            return cv::Rect(b.x / scale, b.y / scale,
+                            std::max(1, b.width / scale),
+                            std::max(1, b.height / scale));
+        };
+        int marker = std::max(6, 20 / scale);
+        for (int i = 0; i < result.tapeCount; ++i)
+            cv::rectangle(image, rect(result.tapes[i]), cv::Scalar(0, 255, 255),
+                          1);
+        for (int i = 0; i < result.cargoCount; ++i)
+            cv::rectangle(image, rect(result.cargo[i].box),
+                          cv::Scalar(255, 0, 255), scale > 1 ? 1 : 2);
+        cv::Point mid(image.cols / 2, image.rows / 2);
+        cv::drawMarker(image, mid, cv::Scalar(255, 255, 255), cv::MARKER_CROSS,
+                       marker, 1);
+        if (result.found)
+            cv::drawMarker(image,
+                           cv::Point(static_cast<int>(result.centreX / scale),
+                                     static_cast<int>(result.centreY / scale)),
+                           cv::Scalar(0, 0, 255), cv::MARKER_TILTED_CROSS,
+                           marker, scale > 1 ? 1 : 2);
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_STREAMTHREAD
+#define TEXASTORQUE_STREAMTHREAD
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "cscore_cv.h"
+#include "opencv2/core.hpp"
+
+#include "Histogram.hh"
+#include "RayTable.hh"
+#include "Realtime.hh"
+#include "Result.hh"
+#include "TripleBuffer.hh"
+
+namespace texastorque {
+    // Debug stream settings, read from frc.json.
+    struct StreamConfig {
+        int scale = 1;           // downscale factor before anything else
+        bool undistort = false;  // needs a calibration
+        bool overlay = true;     // draw tapes, cargo and crosshairs
+        RealtimeConfig realtime{-1, 0, false, 10};  // niced below vision
+    };
+
+    // Feeds the debug stream from its own low-priority thread so scaling,
+    // overlays, undistortion and JPEG encoding stay off the vision
+    // thread. Frames and results pass through a triple buffer: the vision
+    // thread flips straight into Frame() and publishes it without copying
+    // or waiting, and the stream thread always takes the newest, so when
+    // it falls behind the frames in between are skipped. Each frame is
+    // downscaled, then drawn on, then undistorted with a fixed-point
+    // remap (CV_16SC2 + CV_16UC1 maps) built once per streamed size.
+    class StreamThread {
+    public:
+        StreamThread(cs::CvSource source, const StreamConfig& config,
+                     const CameraCalibration& calibration);
+        ~StreamThread();
+
+        StreamThread(const StreamThread&) = delete;
+        StreamThread& operator=(const StreamThread&) = delete;
+
+        void Start();
+        void Stop();
+
+        // Vision thread side. The buffer to build this frame in; it stays
+        // the vision thread's until Publish().
+        cv::Mat& Frame() {
+            return buffer.Back().frame;
+        }
+
+        // Hands Frame() and its result to the stream thread. Returns false
+        // if that replaced a frame the stream thread never got to.
+        bool Publish(const Result& result);
+
+        // Extra downscale on top of config.scale, for the thermal
+        // governor. Takes effect from the next frame.
+        void SetScale(int scale) {
+            extraScale.store(scale, std::memory_order_relaxed);
+        }
+
+        // Scale, draw, remap and PutFrame time per streamed frame.
+        Histogram latency;
+
+    private:
+        cs::CvSource source;
+        StreamConfig config;
+        CameraCalibration calibration;
+        std::atomic<int> extraScale{1};
+
+        struct Slot {
+            cv::Mat frame;
+            Result result;
+        };
+        TripleBuffer<Slot> buffer;
+
+        // Only for sleeping between frames; the handoff itself is the
+        // triple buffer.
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::atomic<bool> running{false};
+        std::thread thread;
+
+        cv::Mat scaled, undistorted;
+        cv::Size mapSize;
+        cv::Mat map1, map2;
+
+        void Run();
+        void BuildMaps(const cv::Size& size);
+        void Draw(cv::Mat& image, const Result& result, int scale) const;
+    };
+}
+
+#endif
@@ -0,0 +1,58 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "SystemStats.hh"
+
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace texastorque {
+    static bool ReadNumber(const char* path, double& value) {
+        FILE* f = std::fopen(path, "r");
+        if (f == nullptr) return false;
+        bool ok = std::fscanf(f, "%lf", &value) == 1;
+        std::fclose(f);
+        return ok;
+    }
+
+    SystemStats ReadSystemStats() {
+        SystemStats stats;
+        double value;
+
+        if (ReadNumber("/sys/class/thermal/thermal_zone0/temp", value))
+            stats.cpuTemperature = value / 1000.0;
+        if (ReadNumber("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq",
+                       value))
+            stats.cpuFrequency = value / 1000.0;
+        if (ReadNumber("/sys/devices/system/cpu/cpu0/cpufreq/scaling_max_freq",
+                       value))
+            stats.cpuMaxFrequency = value / 1000.0;
+
+        if (FILE* f = std::fopen("/proc/meminfo", "r")) {
+            char line[128], key[64];
+            long long kb;
+            while (std::fgets(line, sizeof(line), f) != nullptr) {
+                if (std::sscanf(line, "%63s %lld", key, &kb) != 2) continue;
+                if (std::strcmp(key, "MemTotal:") == 0)
+                    stats.memTotal = kb * 1024;
+                else if (std::strcmp(key, "MemAvailable:") == 0)
+                    stats.memAvailable = kb * 1024;
+            }
+            std::fclose(f);
+        }
+
+        if (FILE* f = std::fopen("/proc/self/statm", "r")) {
+            long long size, resident;
+            if (std::fscanf(f, "%lld %lld", &size, &resident) == 2)
+                stats.processRss = resident * sysconf(_SC_PAGESIZE);
+            std::fclose(f);
+        }
+
+        return stats;
+    }
+}
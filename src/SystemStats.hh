@@ -0,0 +1,27 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_SYSTEMSTATS
+#define TEXASTORQUE_SYSTEMSTATS
+
+#include <cstdint>
+
+namespace texastorque {
+    // Snapshot of coprocessor health read from /sys and /proc. Fields
+    // that cannot be read (e.g. when running off the Pi) are left at -1.
+    struct SystemStats {
+        double cpuTemperature = -1;   // degrees C
+        double cpuFrequency = -1;     // MHz, cpu0
+        double cpuMaxFrequency = -1;  // MHz, cpu0
+        int64_t memTotal = -1;        // bytes
+        int64_t memAvailable = -1;    // bytes
+        int64_t processRss = -1;      // bytes
+    };
+
+    SystemStats ReadSystemStats();
+}
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "TapeTracker.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "opencv2/imgproc.hpp"
+#include "opencv2/video/tracking.hpp"
+
+namespace texastorque {
+    TapeTracker::TapeTracker(const TrackerConfig& config)
+            : config(config), window(config.window, config.window) {}
+
+    bool TapeTracker::NeedsDetection() const {
+        return forced || !Enabled() ||
+               sinceDetection + 1 >= config.detectEvery;
+    }
+
+    void TapeTracker::Reset(const cv::Mat& bgr, const Result& result) {
+        sinceDetection = 0;
+        forced = !result.found || result.confidence < config.minConfidence;
+        if (!Enabled()) return;
+
+        tapeCount = result.tapeCount;
+        points.clear();
+        if (tapeCount == 0) return;
+
+        // The tapes' extent plus as far as the coarsest pyramid level can
+        // follow them.
+        cv::Rect extent;
+        for (int i = 0; i < tapeCount; ++i) {
+            const Box& b = result.tapes[i];
+            tapes[i] = b;
+            extent |= cv::Rect(b.x, b.y, b.width, b.height);
+        }
+        int margin = window.width << config.levels;
+        region = cv::Rect(extent.x - margin, extent.y - margin,
+                          extent.width + 2 * margin,
+                          extent.height + 2 * margin) &
+                 cv::Rect(cv::Point(), bgr.size());
+        if (region.empty()) return;
+
+        for (int i = 0; i < tapeCount; ++i) {
+            const Box& b = tapes[i];
+            float x = static_cast<float>(b.x - region.x);
+            float y = static_cast<float>(b.y - region.y);
+            points.emplace_back(x, y);
+            points.emplace_back(x + b.width, y);
+            points.emplace_back(x + b.width, y + b.height);
+            points.emplace_back(x, y + b.height);
+        }
+        cv::cvtColor(bgr(region), gray, cv::COLOR_BGR2GRAY);
+        cv::buildOpticalFlowPyramid(gray, prevPyramid, window, config.levels);
+    }
+
+    bool TapeTracker::Track(const cv::Mat& bgr, Result& result) {
+        if (points.empty()) {
+            forced = true;
+            return false;
+        }
+
+        // The pyramid copies gray into its own bordered level 0, so gray
+        // is free to be reused next frame.
+        cv::cvtColor(bgr(region), gray, cv::COLOR_BGR2GRAY);
+        cv::buildOpticalFlowPyramid(gray, pyramid, window, config.levels);
+        cv::calcOpticalFlowPyrLK(prevPyramid, pyramid, points, next, status,
+                                 error, window, config.levels);
+        cv::calcOpticalFlowPyrLK(pyramid, prevPyramid, next, back, backStatus,
+                                 error, window, config.levels);
+
+        // Drift check: a corner is kept if it tracks there and back again,
+        // and stays inside the region with room for its window.
+        cv::Rect2f inside(window.width / 2.0f, window.height / 2.0f,
+                          region.width - window.width,
+                          region.height - window.height);
+        int kept = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            double dx = back[i].x - points[i].x, dy = back[i].y - points[i].y;
+            status[i] = status[i] && backStatus[i] &&
+                        dx * dx + dy * dy <= config.maxError * config.maxError &&
+                        inside.contains(next[i]);
+            kept += status[i];
+        }
+        if (kept == 0 || kept < config.minTracked * points.size()) {
+            forced = true;
+            return false;
+        }
+
+        // Each tape follows its surviving corners; a tape with none left
+        // follows the average motion of the others.
+        double meanX = 0, meanY = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (!status[i]) continue;
+            meanX += next[i].x - points[i].x;
+            meanY += next[i].y - points[i].y;
+        }
+        meanX /= kept;
+        meanY /= kept;
+
+        for (int t = 0; t < tapeCount; ++t) {
+            double dx = 0, dy = 0;
+            int n = 0;
+            for (int c = 0; c < 4; ++c) {
+                size_t i = t * 4 + c;
+                if (!status[i]) continue;
+                dx += next[i].x - points[i].x;
+                dy += next[i].y - points[i].y;
+                ++n;
+            }
+            if (n == 0) {
+                dx = meanX;
+                dy = meanY;
+            } else {
+                dx /= n;
+                dy /= n;
+            }
+            Box& b = tapes[t];
+            b.x = static_cast<int>(std::lround(b.x + dx));
+            b.y = static_cast<int>(std::lround(b.y + dy));
+            for (int c = 0; c < 4; ++c) {
+                size_t i = t * 4 + c;
+                points[i].x += dx;
+                points[i].y += dy;
+            }
+        }
+
+        result.tapeCount = tapeCount;
+        std::copy(tapes, tapes + tapeCount, result.tapes);
+
+        std::swap(prevPyramid, pyramid);
+        ++sinceDetection;
+        return true;
+    }
+}
@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_TAPETRACKER
+#define TEXASTORQUE_TAPETRACKER
+
+#include <vector>
+
+#include "opencv2/core.hpp"
+
+#include "Result.hh"
+
+namespace texastorque {
+    struct TrackerConfig {
+        int detectEvery = 1;         // full detection every N frames, 1 = off
+        double minConfidence = 0.5;  // re-detect when confidence drops below
+        double maxError = 1.0;       // px, forward-backward drift per point
+        double minTracked = 0.6;     // share of corners that must survive
+        int window = 15;
+        int levels = 2;
+    };
+
+    // Carries tape boxes from the last full detection forward with sparse
+    // pyramidal Lucas-Kanade on their corners, so full detection only runs
+    // every few frames. Each point is tracked forward and back; corners
+    // whose round trip drifts are dropped, and losing too many forces the
+    // next frame back to full detection. Only a region around the tapes,
+    // fixed at each detection, is converted to gray and pyramided; a
+    // corner that moves out of it also loses track.
+    class TapeTracker {
+    public:
+        explicit TapeTracker(const TrackerConfig& config = TrackerConfig{});
+
+        bool Enabled() const {
+            return config.detectEvery > 1;
+        }
+        double MinConfidence() const {
+            return config.minConfidence;
+        }
+
+        // Whether this frame should run full detection.
+        bool NeedsDetection() const;
+
+        // Call with the BGR frame after each full detection.
+        void Reset(const cv::Mat& bgr, const Result& result);
+
+        // Moves the tapes in result to where they are in bgr. Returns
+        // false (and leaves result alone) if tracking was lost.
+        bool Track(const cv::Mat& bgr, Result& result);
+
+        void ForceDetection() {
+            forced = true;
+        }
+
+    private:
+        TrackerConfig config;
+        cv::Size window;
+        int sinceDetection = 0;
+        bool forced = true;
+
+        cv::Rect region;  // tracked part of the frame; points are relative
+        cv::Mat gray;
+        std::vector<cv::Mat> prevPyramid, pyramid;
+        std::vector<cv::Point2f> points, next, back;
+        std::vector<unsigned char> status, backStatus;
+        std::vector<float> error;
+        int tapeCount = 0;
+        Box tapes[Result::kMaxTapes];
+    };
+}
+
+#endif
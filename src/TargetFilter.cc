@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "TargetFilter.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace texastorque {
+    MeasurementFilter::MeasurementFilter(const FilterConfig& config) {
+        SetConfig(config);
+    }
+
+    void MeasurementFilter::SetConfig(const FilterConfig& config) {
+        this->config = config;
+        this->config.window = std::max(1, std::min(config.window, kMaxWindow));
+        Reset();
+    }
+
+    void MeasurementFilter::Reset() {
+        size = 0;
+        head = 0;
+        rejectedRun = 0;
+        output = 0;
+        acceptRate = 1;
+        primed = false;
+    }
+
+    // Ring buffer of the last samples plus an insertion-sorted copy, same
+    // approach as frc::MedianFilter.
+    void MeasurementFilter::Push(double value) {
+        if (size == config.window) {
+            double oldest = window[head];
+            auto it = std::lower_bound(sorted.begin(), sorted.begin() + size,
+                                       oldest);
+            std::move(it + 1, sorted.begin() + size, it);
+            --size;
+        }
+        window[head] = value;
+        head = (head + 1) % config.window;
+
+        auto it = std::upper_bound(sorted.begin(), sorted.begin() + size, value);
+        std::move_backward(it, sorted.begin() + size,
+                           sorted.begin() + size + 1);
+        *it = value;
+        ++size;
+    }
+
+    double MeasurementFilter::Median() const {
+        if (size % 2 == 1) return sorted[size / 2];
+        return (sorted[size / 2 - 1] + sorted[size / 2]) / 2.0;
+    }
+
+    bool MeasurementFilter::Calculate(double value, double dt) {
+        bool accepted = true;
+        if (primed && config.outlierThreshold > 0 &&
+            std::abs(value - Median()) > config.outlierThreshold) {
+            // A run of "outliers" as long as the window is a real move.
+            if (++rejectedRun < config.window) {
+                accepted = false;
+            } else {
+                Reset();
+            }
+        }
+        acceptRate = 0.9 * acceptRate + (accepted ? 0.1 : 0);
+        if (!accepted) return false;
+        rejectedRun = 0;
+
+        Push(value);
+        double median = Median();
+        if (!primed || config.timeConstant <= 0) {
+            output = median;
+        } else {
+            double gain = std::exp(-dt / config.timeConstant);
+            output = gain * output + (1 - gain) * median;
+        }
+        primed = true;
+        return true;
+    }
+
+    TargetFilter::TargetFilter(const TargetFilterConfig& config)
+            : config(config),
+              yaw(config.yaw),
+              pitch(config.pitch),
+              distance(config.distance) {}
+
+    void TargetFilter::Update(Result& result) {
+        double dt = lastTime == 0 ? 0 : (result.frameTime - lastTime) / 1e6;
+        if (!result.found) {
+            if (primed && dt > config.resetAfter) {
+                yaw.Reset();
+                pitch.Reset();
+                distance.Reset();
+                primed = false;
+            }
+            result.filtered = primed;
+            result.filteredConfidence = 0;
+            if (primed) {
+                result.filteredYaw = yaw.Output();
+                result.filteredPitch = pitch.Output();
+                result.filteredDistance = distance.Output();
+            }
+            return;
+        }
+
+        yaw.Calculate(result.yaw, dt);
+        pitch.Calculate(result.pitch, dt);
+        distance.Calculate(result.distance, dt);
+        lastTime = result.frameTime;
+        primed = true;
+
+        result.filtered = true;
+        result.filteredYaw = yaw.Output();
+        result.filteredPitch = pitch.Output();
+        result.filteredDistance = distance.Output();
+        result.filteredConfidence =
+                result.confidence *
+                std::min({yaw.AcceptRate(), pitch.AcceptRate(),
+                          distance.AcceptRate()});
+    }
+}
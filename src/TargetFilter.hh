@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_TARGETFILTER
+#define TEXASTORQUE_TARGETFILTER
+
+#include <array>
+#include <cstdint>
+
+#include "Result.hh"
+
+namespace texastorque {
+    // Moving median followed by a single-pole IIR, with the same
+    // semantics as frc::MedianFilter and frc::LinearFilter::SinglePoleIIR
+    // but on fixed-size storage so an update never allocates (and without
+    // pulling in wpimath, which is not on the Pi image).
+    struct FilterConfig {
+        int window = 5;                // median window, 1 to kMaxWindow
+        double timeConstant = 0.05;    // s, 0 disables the IIR
+        double outlierThreshold = 0;   // reject jumps from the median, 0 off
+    };
+
+    class MeasurementFilter {
+    public:
+        static constexpr int kMaxWindow = 15;
+
+        explicit MeasurementFilter(const FilterConfig& config = FilterConfig{});
+
+        void SetConfig(const FilterConfig& config);
+
+        // Feeds one sample dt seconds after the previous one. Returns
+        // false if the sample was rejected as an outlier; output holds
+        // the filtered value either way.
+        bool Calculate(double value, double dt);
+
+        double Output() const {
+            return output;
+        }
+
+        // Running share of accepted samples, 0 to 1.
+        double AcceptRate() const {
+            return acceptRate;
+        }
+
+        void Reset();
+
+    private:
+        FilterConfig config;
+        std::array<double, kMaxWindow> window{};
+        std::array<double, kMaxWindow> sorted{};
+        int size = 0;
+        int head = 0;
+        int rejectedRun = 0;
+        double output = 0;
+        double acceptRate = 1;
+        bool primed = false;
+
+        void Push(double value);
+        double Median() const;
+    };
+
+    // Filters yaw, pitch and distance of consecutive results and writes
+    // the filtered fields back into the result.
+    struct TargetFilterConfig {
+        FilterConfig yaw;
+        FilterConfig pitch;
+        FilterConfig distance{5, 0.1, 0};
+        double resetAfter = 0.5;  // s without a target before starting over
+    };
+
+    class TargetFilter {
+    public:
+        explicit TargetFilter(
+                const TargetFilterConfig& config = TargetFilterConfig{});
+
+        void Update(Result& result);
+
+    private:
+        TargetFilterConfig config;
+        MeasurementFilter yaw, pitch, distance;
+        uint64_t lastTime = 0;
+        bool primed = false;
+    };
+}
+
+#endif
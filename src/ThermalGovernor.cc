@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "ThermalGovernor.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "wpi/raw_ostream.h"
+
+namespace texastorque {
+    static constexpr LoadLimits kLevels[] = {
+        {1, 1, 1.0, "full"},
+        {2, 1, 1.0, "stream 1/2 fps"},
+        {4, 1, 1.0, "stream 1/4 fps"},
+        {4, 2, 1.0, "stream 1/4 fps, 1/2 size"},
+        {4, 2, 0.5, "stream 1/4 fps, 1/2 size, cargo 1/2 rate"},
+        {0, 2, 0.25, "stream off, cargo 1/4 rate"},
+    };
+    static constexpr int kLevelCount = sizeof(kLevels) / sizeof(kLevels[0]);
+
+    ThermalGovernor::ThermalGovernor(const ThermalConfig& config,
+                                     std::shared_ptr<nt::NetworkTable> table)
+            : config(config) {
+        temperatureEntry = table->GetEntry("temperature");
+        frequencyEntry = table->GetEntry("frequency");
+        cappedEntry = table->GetEntry("capped");
+        levelEntry = table->GetEntry("level");
+        limitsEntry = table->GetEntry("limits");
+        decisionEntry = table->GetEntry("decision");
+        levelEntry.SetDouble(0);
+        limitsEntry.SetString(kLevels[0].name);
+    }
+
+    const LoadLimits& ThermalGovernor::Limits() const {
+        return kLevels[level];
+    }
+
+    int ThermalGovernor::Target(double temperature) const {
+        int target = 0;
+        if (temperature >= config.startTemperature)
+            target = 1 + static_cast<int>(std::floor(
+                    (temperature - config.startTemperature) /
+                    std::max(config.step, 0.1)));
+        if (capped) target++;
+        return std::min(target, kLevelCount - 1);
+    }
+
+    void ThermalGovernor::UpdateCapped(const SystemStats& stats,
+                                       Clock::time_point now) {
+        bool slow = stats.cpuFrequency > 0 && stats.cpuMaxFrequency > 0 &&
+                    stats.cpuFrequency <
+                            config.throttleRatio * stats.cpuMaxFrequency;
+        if (slow) fullSpeedSince = now;
+        if (slow && stats.cpuTemperature >= config.startTemperature) {
+            capped = true;
+        } else if (stats.cpuTemperature <
+                           config.startTemperature - config.hysteresis ||
+                   now - fullSpeedSince >=
+                           std::chrono::duration<double>(config.hold)) {
+            capped = false;
+        }
+    }
+
+    bool ThermalGovernor::Update(const SystemStats& stats) {
+        auto now = Clock::now();
+        UpdateCapped(stats, now);
+        temperatureEntry.SetDouble(stats.cpuTemperature);
+        frequencyEntry.SetDouble(stats.cpuFrequency);
+        cappedEntry.SetBoolean(capped);
+        if (!config.enabled) return false;
+
+        if (now - lastChange < std::chrono::duration<double>(config.hold))
+            return false;
+
+        // Step up as soon as a threshold is crossed, but only step down
+        // once the temperature has fallen clear of it.
+        int next = level;
+        if (Target(stats.cpuTemperature) > level)
+            next = level + 1;
+        else if (Target(stats.cpuTemperature + config.hysteresis) < level)
+            next = level - 1;
+        if (next == level) return false;
+
+        char decision[160];
+        std::snprintf(decision, sizeof(decision),
+                      "%s to %d (%s): %.1f C, %.0f/%.0f MHz",
+                      next > level ? "down" : "up", next, kLevels[next].name,
+                      stats.cpuTemperature, stats.cpuFrequency,
+                      stats.cpuMaxFrequency);
+        wpi::outs() << "Thermal governor: " << decision << '\n';
+
+        level = next;
+        lastChange = now;
+        levelEntry.SetDouble(level);
+        limitsEntry.SetString(kLevels[level].name);
+        decisionEntry.SetString(decision);
+        return true;
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_THERMALGOVERNOR
+#define TEXASTORQUE_THERMALGOVERNOR
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "networktables/NetworkTable.h"
+#include "networktables/NetworkTableEntry.h"
+
+#include "SystemStats.hh"
+
+namespace texastorque {
+    // Temperatures at which the governor sheds load, read from frc.json.
+    struct ThermalConfig {
+        bool enabled = true;
+        double startTemperature = 70;  // C, first step down
+        double step = 3;               // C between further steps
+        double hysteresis = 3;         // C below a step before undoing it
+        double throttleRatio = 0.95;   // cur / max frequency counted as capped
+        double hold = 5;               // s between changes
+    };
+
+    // Non-critical work allowed at one governor level. Hub targeting is
+    // never limited.
+    struct LoadLimits {
+        int streamDivisor;  // stream every n-th frame, 0 for none
+        int streamScale;    // stream downscale factor
+        double cargoRate;   // fraction of the configured cargo rate
+        const char* name;
+    };
+
+    // Steps non-critical load down as the Pi heats up, in priority order:
+    // debug stream frame rate, then its resolution, then the cargo
+    // detector rate. A level is added for every config.step degrees over
+    // config.startTemperature, and one more while the firmware is capping
+    // the clock. Capping only counts at or above config.startTemperature,
+    // because the ondemand cpufreq governor idles a cool Pi below its
+    // maximum too, and it is held until the temperature is
+    // config.hysteresis below the start or the clock has been back at
+    // full speed for config.hold. Levels change one at a time,
+    // at most once per config.hold, and come back only once the
+    // temperature is config.hysteresis below the level's threshold.
+    // Update() once a second from the main loop.
+    class ThermalGovernor {
+    public:
+        ThermalGovernor(const ThermalConfig& config,
+                        std::shared_ptr<nt::NetworkTable> table);
+
+        // Returns true when the level changed and the limits should be
+        // applied.
+        bool Update(const SystemStats& stats);
+
+        int Level() const {
+            return level;
+        }
+        const LoadLimits& Limits() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        ThermalConfig config;
+        int level = 0;
+        Clock::time_point lastChange{};
+        bool capped = false;
+        Clock::time_point fullSpeedSince{};
+
+        nt::NetworkTableEntry temperatureEntry;
+        nt::NetworkTableEntry frequencyEntry;
+        nt::NetworkTableEntry cappedEntry;
+        nt::NetworkTableEntry levelEntry;
+        nt::NetworkTableEntry limitsEntry;
+        nt::NetworkTableEntry decisionEntry;
+
+        int Target(double temperature) const;
+        void UpdateCapped(const SystemStats& stats, Clock::time_point now);
+    };
+}
+
+#endif
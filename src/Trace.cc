@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "Trace.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <pthread.h>
+
+#include "Metrics.hh"
+
+namespace texastorque {
+    std::atomic<bool> traceEnabled{false};
+
+    namespace {
+        constexpr uint32_t kCapacity = 1 << 16;  // spans per thread
+
+        struct TraceEvent {
+            const char* name;
+            int64_t start;
+            int64_t duration;
+        };
+
+        // Written only by its thread. count is published with release so
+        // TraceWrite sees whole events; a thread that finds a stale
+        // generation empties its own buffer. written and owned are only
+        // touched under registryMutex.
+        struct TraceBuffer {
+            std::unique_ptr<TraceEvent[]> events{new TraceEvent[kCapacity]};
+            std::atomic<uint32_t> count{0};
+            std::atomic<uint32_t> generation{0};
+            std::atomic<uint64_t> dropped{0};
+            uint32_t written = 0;  // last generation TraceWrite saved
+            bool owned = true;     // false once its thread has exited
+            int tid;
+            char threadName[16];
+        };
+
+        std::atomic<uint32_t> generation{0};
+
+        // Buffers outlive their threads so a session can be written after
+        // a thread exits. An exited thread's buffer is handed to the next
+        // new thread once nothing in it is still unwritten, so restarted
+        // threads do not grow the registry (or locked memory).
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<TraceBuffer>> registry;
+
+        // Releases the thread's buffer when the thread exits.
+        struct LocalSlot {
+            TraceBuffer* buffer = nullptr;
+
+            ~LocalSlot() {
+                if (buffer == nullptr) return;
+                std::lock_guard<std::mutex> lock(registryMutex);
+                buffer->owned = false;
+            }
+        };
+
+        thread_local LocalSlot localSlot;
+
+        // A free buffer holds nothing TraceWrite still needs: its spans
+        // are from an older session, or have already been written.
+        bool Reusable(const TraceBuffer& buffer, uint32_t current) {
+            if (buffer.owned) return false;
+            uint32_t g = buffer.generation.load(std::memory_order_relaxed);
+            return g != current || buffer.written == current ||
+                   buffer.count.load(std::memory_order_relaxed) == 0;
+        }
+
+        TraceBuffer* LocalBuffer() {
+            if (localSlot.buffer != nullptr) return localSlot.buffer;
+            char threadName[16];
+            if (pthread_getname_np(pthread_self(), threadName,
+                                   sizeof(threadName)) != 0)
+                threadName[0] = '\0';
+
+            std::lock_guard<std::mutex> lock(registryMutex);
+            uint32_t current = generation.load(std::memory_order_acquire);
+            TraceBuffer* buffer = nullptr;
+            for (const auto& b : registry) {
+                if (!Reusable(*b, current)) continue;
+                buffer = b.get();
+                buffer->owned = true;
+                buffer->count.store(0, std::memory_order_relaxed);
+                buffer->dropped.store(0, std::memory_order_relaxed);
+                buffer->generation.store(current, std::memory_order_release);
+                break;
+            }
+            if (buffer == nullptr) {
+                registry.push_back(std::make_unique<TraceBuffer>());
+                buffer = registry.back().get();
+                buffer->tid = static_cast<int>(registry.size());
+            }
+            std::copy(threadName, threadName + sizeof(threadName),
+                      buffer->threadName);
+            localSlot.buffer = buffer;
+            return buffer;
+        }
+
+        // Span names are literals; escape anyway so a stray quote cannot
+        // break the file.
+        void WriteString(std::FILE* file, const char* s) {
+            std::fputc('"', file);
+            for (; *s != '\0'; ++s) {
+                if (*s == '"' || *s == '\\') std::fputc('\\', file);
+                if (static_cast<unsigned char>(*s) >= 0x20) std::fputc(*s, file);
+            }
+            std::fputc('"', file);
+        }
+    }
+
+    void TraceStart() {
+        generation.fetch_add(1, std::memory_order_release);
+        traceEnabled.store(true, std::memory_order_release);
+    }
+
+    void TraceStop() {
+        traceEnabled.store(false, std::memory_order_release);
+    }
+
+    void TraceComplete(const char* name, int64_t start, int64_t end) {
+        if (!TraceEnabled()) return;
+        TraceBuffer* buffer = LocalBuffer();
+        uint32_t current = generation.load(std::memory_order_acquire);
+        if (buffer->generation.load(std::memory_order_relaxed) != current) {
+            buffer->count.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+            buffer->generation.store(current, std::memory_order_release);
+        }
+        uint32_t n = buffer->count.load(std::memory_order_relaxed);
+        if (n >= kCapacity) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer->events[n] = {name, start, end - start};
+        buffer->count.store(n + 1, std::memory_order_release);
+    }
+
+    TraceSpan::TraceSpan(const char* name)
+            : name(name), start(TraceEnabled() ? MicrosNow() : 0) {}
+
+    TraceSpan::~TraceSpan() {
+        if (start != 0) TraceComplete(name, start, MicrosNow());
+    }
+
+    long TraceWrite(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) return -1;
+
+        uint32_t current = generation.load(std::memory_order_acquire);
+        long spans = 0;
+        bool first = true;
+        std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& buffer : registry) {
+            if (buffer->generation.load(std::memory_order_acquire) != current)
+                continue;
+            uint32_t count = buffer->count.load(std::memory_order_acquire);
+            buffer->written = current;
+
+            std::fprintf(file,
+                         "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                         "\"tid\":%d,\"args\":{\"name\":",
+                         first ? "" : ",", buffer->tid);
+            WriteString(file, buffer->threadName[0] != '\0'
+                                      ? buffer->threadName : "unnamed");
+            std::fprintf(file, ",\"dropped\":%llu}}",
+                         static_cast<unsigned long long>(buffer->dropped.load()));
+            first = false;
+
+            for (uint32_t i = 0; i < count; ++i) {
+                const TraceEvent& e = buffer->events[i];
+                std::fputs(",{\"name\":", file);
+                WriteString(file, e.name);
+                std::fprintf(file,
+                             ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,"
+                             "\"dur\":%lld}",
+                             buffer->tid, static_cast<long long>(e.start),
+                             static_cast<long long>(e.duration));
+                ++spans;
+            }
+        }
+        std::fputs("]}\n", file);
+        bool ok = std::fclose(file) == 0;
+        return ok ? spans : -1;
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_TRACE
+#define TEXASTORQUE_TRACE
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace texastorque {
+    // On-demand timeline recording in Chrome trace format (load the file
+    // in chrome://tracing or ui.perfetto.dev). Each thread appends spans
+    // to its own fixed-size buffer without locking; a full buffer drops
+    // further spans until the next session. Span names must be string
+    // literals (or otherwise outlive the session).
+    extern std::atomic<bool> traceEnabled;
+
+    inline bool TraceEnabled() {
+        return traceEnabled.load(std::memory_order_relaxed);
+    }
+
+    // Starts a new session, discarding the previous one.
+    void TraceStart();
+    void TraceStop();
+
+    // Writes the last session's spans as trace JSON. Call after
+    // TraceStop(). Returns the number of spans written, or -1 on error.
+    long TraceWrite(const std::string& path);
+
+    // Records a span with MicrosNow() timestamps.
+    void TraceComplete(const char* name, int64_t start, int64_t end);
+
+    // Records the enclosing scope.
+    class TraceSpan {
+    public:
+        explicit TraceSpan(const char* name);
+        ~TraceSpan();
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        const char* name;
+        int64_t start;
+    };
+}
+
+#endif
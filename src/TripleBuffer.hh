@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_TRIPLEBUFFER
+#define TEXASTORQUE_TRIPLEBUFFER
+
+#include <array>
+#include <atomic>
+
+namespace texastorque {
+    // Single-writer, single-reader handoff of the newest value. The
+    // writer fills Back() in place and publishes it; the reader takes
+    // the newest published slot. Neither side waits or copies, and a
+    // value the reader never took is simply overwritten. Unlike Seqlock
+    // this works for values that own memory, like cv::Mat.
+    template <typename T>
+    class TripleBuffer {
+    public:
+        // Writer side.
+        T& Back() {
+            return slots[back];
+        }
+
+        // Swaps Back() into the middle. Returns false if that overwrote
+        // a value the reader had not taken yet.
+        bool Publish() {
+            int previous = middle.exchange(back | kFresh,
+                                           std::memory_order_acq_rel);
+            back = previous & kIndex;
+            return (previous & kFresh) == 0;
+        }
+
+        // Reader side. Takes the newest value into Front(), if there is
+        // one it has not seen.
+        bool Update() {
+            if ((middle.load(std::memory_order_relaxed) & kFresh) == 0)
+                return false;
+            front = middle.exchange(front, std::memory_order_acq_rel) & kIndex;
+            return true;
+        }
+
+        T& Front() {
+            return slots[front];
+        }
+
+    private:
+        static constexpr int kIndex = 3;
+        static constexpr int kFresh = 4;
+
+        std::array<T, 3> slots{};
+        int back = 0;
+        int front = 1;
+        std::atomic<int> middle{2};
+    };
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "VisionThread.hh"
+
+#include <exception>
+
+#include "wpi/raw_ostream.h"
+
+namespace texastorque {
+    VisionThread::VisionThread(std::string name, cs::VideoSource camera,
+                               cs::CvSource output,
+                               nt::NetworkTableInstance& ntinst,
+                               const RealtimeConfig& realtime,
+                               const PipelineConfig& pipelineConfig,
+                               std::shared_ptr<VisionWatchdog> watchdog,
+                               std::function<void()> onFrame)
+            : name(name), camera(camera), realtime(realtime),
+              watchdog(watchdog), onFrame(onFrame) {
+        pipeline = std::make_unique<Pipeline>(name, ntinst, output,
+                                              pipelineConfig);
+    }
+
+    VisionThread::~VisionThread() {
+        if (Stop()) return;
+        thread.detach();
+        pipeline.release();
+        wpi::errs() << "Vision thread '" << name
+                    << "' did not stop, abandoning it\n";
+    }
+
+    void VisionThread::Start() {
+        if (thread.joinable()) return;
+        loop = std::make_shared<Loop>();
+        loop->sink = cs::CvSink("sink-" + name);
+        loop->sink.SetSource(camera);
+        watchdog->Reset();
+
+        // The thread only captures things that outlive a detached thread:
+        // the loop and watchdog by shared_ptr, the pipeline by raw pointer
+        // (leaked in that case) and onFrame by copy.
+        std::promise<void> done;
+        finished = done.get_future();
+        auto state = loop;
+        auto run = pipeline.get();
+        auto dog = watchdog;
+        auto notify = onFrame;
+        auto rt = realtime;
+        auto threadName = "vision-" + name;
+        thread = std::thread([state, run, dog, notify, rt, threadName,
+                              done = std::move(done)]() mutable {
+            ApplyRealtime(rt, threadName);
+            try {
+                cv::Mat frame;
+                std::string lastError;
+                while (state->running.load(std::memory_order_relaxed)) {
+                    uint64_t captureTime = state->sink.GrabFrame(frame);
+                    if (captureTime == 0) {
+                        std::string error = state->sink.GetError();
+                        if (error != lastError)
+                            wpi::errs() << threadName << ": " << error << '\n';
+                        lastError = error;
+                        continue;
+                    }
+                    lastError.clear();
+                    run->Process(frame, captureTime);
+                    dog->Reset();
+                    if (notify) notify();
+                }
+            } catch (const std::exception& e) {
+                wpi::errs() << threadName << " died: " << e.what() << '\n';
+            } catch (...) {
+                wpi::errs() << threadName << " died: unknown exception\n";
+            }
+            done.set_value();
+        });
+    }
+
+    // GrabFrame times out after 225 ms, so the loop notices the stop
+    // flag promptly even when the camera has gone quiet.
+    bool VisionThread::Stop(std::chrono::milliseconds timeout) {
+        if (!thread.joinable()) return true;
+        loop->running = false;
+        if (finished.wait_for(timeout) != std::future_status::ready)
+            return false;
+        thread.join();
+        loop.reset();
+        wpi::outs() << "Stopped vision thread '" << name << "'\n";
+        return true;
+    }
+
+    bool VisionThread::Finished() const {
+        return !thread.joinable() ||
+               finished.wait_for(std::chrono::seconds(0)) ==
+                       std::future_status::ready;
+    }
+}
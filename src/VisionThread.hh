@@ -0,0 +1,81 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_VISIONTHREAD
+#define TEXASTORQUE_VISIONTHREAD
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "cscore_cv.h"
+#include "networktables/NetworkTableInstance.h"
+
+#include "Pipeline.hh"
+#include "Realtime.hh"
+#include "VisionWatchdog.hh"
+
+namespace texastorque {
+    // Owns a pipeline, the sink feeding it and the thread running it,
+    // so the main loop can stop and join it instead of detaching. Frames
+    // are grabbed from a CvSink directly rather than through
+    // frc::VisionRunner, which drops GrabFrame's capture timestamp. Every
+    // processed frame feeds the watchdog and then calls onFrame, which
+    // must be thread-safe (e.g. a uv::Async send).
+    class VisionThread {
+    public:
+        VisionThread(std::string name, cs::VideoSource camera,
+                     cs::CvSource output, nt::NetworkTableInstance& ntinst,
+                     const RealtimeConfig& realtime,
+                     const PipelineConfig& pipelineConfig,
+                     std::shared_ptr<VisionWatchdog> watchdog,
+                     std::function<void()> onFrame = {});
+        // Stops the thread. One that is still wedged is detached and its
+        // sink and pipeline leaked rather than destroyed under it, which
+        // only happens on the way out of the process.
+        ~VisionThread();
+
+        VisionThread(const VisionThread&) = delete;
+        VisionThread& operator=(const VisionThread&) = delete;
+
+        void Start();
+
+        // Stops the loop and joins the thread. Returns false if the thread
+        // is wedged (e.g. stuck inside Process) and did not finish within
+        // timeout; it has still been told to stop, and Finished() says
+        // when it has. The pipeline is only destroyed once it has.
+        bool Stop(std::chrono::milliseconds timeout =
+                          std::chrono::milliseconds(1000));
+        bool Finished() const;
+
+        Pipeline& GetPipeline() {
+            return *pipeline;
+        }
+
+    private:
+        std::string name;
+        cs::VideoSource camera;
+        RealtimeConfig realtime;
+        std::shared_ptr<VisionWatchdog> watchdog;
+        std::function<void()> onFrame;
+        std::unique_ptr<Pipeline> pipeline;
+
+        // Shared with the thread, so it outlives a detached one.
+        struct Loop {
+            cs::CvSink sink;
+            std::atomic<bool> running{true};
+        };
+        std::shared_ptr<Loop> loop;
+        std::thread thread;
+        std::future<void> finished;
+    };
+}
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#include "VisionWatchdog.hh"
+
+#include "wpi/raw_ostream.h"
+#include "wpi/timestamp.h"
+
+namespace texastorque {
+    static int64_t Now() {
+        return static_cast<int64_t>(wpi::Now());
+    }
+
+    VisionWatchdog::VisionWatchdog(double timeout,
+                                   std::function<void()> callback)
+            : lastFeed(Now()),
+              timeout(static_cast<int64_t>(timeout * 1e6)),
+              callback(callback) {}
+
+    double VisionWatchdog::GetTime() const {
+        return (Now() - lastFeed.load(std::memory_order_relaxed)) / 1e6;
+    }
+
+    void VisionWatchdog::SetTimeout(double timeout) {
+        this->timeout.store(static_cast<int64_t>(timeout * 1e6));
+    }
+
+    double VisionWatchdog::GetTimeout() const {
+        return timeout.load() / 1e6;
+    }
+
+    bool VisionWatchdog::IsExpired() const {
+        return Now() - lastFeed.load(std::memory_order_relaxed) >
+               timeout.load(std::memory_order_relaxed);
+    }
+
+    void VisionWatchdog::Reset() {
+        lastFeed.store(Now(), std::memory_order_relaxed);
+    }
+
+    bool VisionWatchdog::Check() {
+        if (!IsExpired()) {
+            fired = false;
+            return false;
+        }
+        if (fired) return false;
+        fired = true;
+        wpi::errs() << "Vision watchdog expired after " << GetTime() << "s\n";
+        if (callback) callback();
+        return true;
+    }
+}
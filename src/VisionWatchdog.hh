@@ -0,0 +1,47 @@
+/**
+ * Copyright (c) Texas Torque 2022
+ *
+ * @author Justus Languell
+ */
+
+#ifndef TEXASTORQUE_VISIONWATCHDOG
+#define TEXASTORQUE_VISIONWATCHDOG
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace texastorque {
+    // Heartbeat watchdog for the vision loop, after frc::Watchdog but
+    // polled from the main event loop instead of a HAL notifier (which
+    // does not exist on the coprocessor). The vision thread calls Reset()
+    // once per processed frame; the main loop calls Check(), which fires
+    // the callback once per expiry.
+    class VisionWatchdog {
+    public:
+        VisionWatchdog(double timeout, std::function<void()> callback);
+
+        // Seconds since the watchdog was last fed.
+        double GetTime() const;
+
+        void SetTimeout(double timeout);
+        double GetTimeout() const;
+
+        bool IsExpired() const;
+
+        // Feeds the watchdog. Safe to call from any thread.
+        void Reset();
+
+        // Runs the callback if the timeout has elapsed since the last
+        // Reset(). Returns true if it fired.
+        bool Check();
+
+    private:
+        std::atomic<int64_t> lastFeed;
+        std::atomic<int64_t> timeout;
+        std::function<void()> callback;
+        bool fired = false;
+    };
+}
+
+#endif